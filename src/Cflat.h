@@ -11,10 +11,10 @@
 - Types of constructors:
     - cflat_xxx_alloc:
         - Allocates memory for an object and returns a pointer to it       
-        - Takes in `CflatArena *a` as first argument
+        - Takes in the allocator as first argument, a `CflatArena *a` or any `CflatAllocator`
     - cflat_xxx_new:
         - Allocates memory and initializes the object
-        - Takes in `CflatArena *a` as first argument
+        - Takes in the allocator as first argument, a `CflatArena *a` or any `CflatAllocator`
     - cflat_xxx_init: 
         - Initializes memory
         - Should never allocate memory
@@ -49,6 +49,7 @@ extern "C"
 
 #include "CflatCore.h"
 #include "CflatArena.h"
+#include "CflatAllocator.h"
 #include "CflatAppend.h"
 #include "CflatSlice.h"
 #include "CflatString.h"
@@ -161,6 +161,15 @@ c32* cflat_store_v256cf(c32 *dst, CflatVec256cf src) {
     #endif
 }
 
+c32* cflat_store_unaligned_v256cf(c32 *dst, CflatVec256cf src) {
+    #if defined(__AVX__)
+    _mm256_storeu_ps((f32*)dst, src.v);
+    return dst;
+    #else
+    return cflat_mem_copy(dst, src.v, sizeof(src.v));
+    #endif
+}
+
 CflatVec256cf cflat_broadcast_v256cf(c32 x) {
     #if defined(__AVX__)
     f64 f = cflat_bit_cast(f64, c32, x);
@@ -0,0 +1,188 @@
+#ifndef CFLAT_ALLOCATOR_H
+#define CFLAT_ALLOCATOR_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+
+/*
+ Type erased allocator the containers allocate through
+ Passed by value, an allocator is a vtable and the context it operates on
+ Every container entry point takes anything cflat_allocator accepts, so a CflatArena* keeps working as is
+*/
+
+/*
+@param alloc:  returns size bytes, aligned and cleared as opt says, NULL on failure
+@param resize: grows or shrinks ptr from old_size to new_size, may move it, a NULL ptr allocates
+@param free:   returns ptr of size bytes, NULL is ignored
+*/
+typedef struct cflat_allocator_vtable {
+    void* (*alloc) (void *ctx, usize size, CflatAllocOpt opt);
+    void* (*resize)(void *ctx, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt);
+    void  (*free)  (void *ctx, void *ptr, usize size);
+} CflatAllocatorVtable;
+
+typedef struct cflat_allocator {
+    const CflatAllocatorVtable *vtable;
+    void *ctx;
+} CflatAllocator;
+
+/*
+Allocates from an arena, free only gives memory back when it is the last thing pushed
+@param arena: the arena
+*/
+CFLAT_DEF CflatAllocator cflat_arena_allocator    (CflatArena *arena                                                          );
+
+/*
+Allocates with malloc/realloc/free, alignments above max_align_t use aligned allocations
+*/
+CFLAT_DEF CflatAllocator cflat_libc_allocator     (void                                                                       );
+
+/*
+Returns the arena behind the allocator, NULL if it is not an arena allocator
+@param allocator: the allocator
+*/
+CFLAT_DEF CflatArena*    cflat_allocator_arena    (CflatAllocator allocator                                                   );
+
+CFLAT_DEF void*          cflat_allocator_alloc_opt (CflatAllocator allocator, usize size, CflatAllocOpt opt                    );
+CFLAT_DEF void*          cflat_allocator_resize_opt(CflatAllocator allocator, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt);
+CFLAT_DEF void           cflat_allocator_free      (CflatAllocator allocator, void *ptr, usize size                            );
+
+static inline CflatAllocator cflat__allocator_identity(CflatAllocator allocator) { return allocator; }
+
+// Turns a CflatArena* or a CflatAllocator into a CflatAllocator
+#define cflat_allocator(A) _Generic((A)                                            \
+    , CflatArena*:                  cflat_arena_allocator                           \
+    , CflatAllocator:               cflat__allocator_identity                       \
+)((A))
+
+#define cflat_allocator_alloc(A, size, ...)                        CFLAT_OPT(cflat_allocator_alloc_opt(cflat_allocator(A), (size), (CflatAllocOpt){ .align = cflat_alignof(uptr), __VA_ARGS__ }))
+#define cflat_allocator_resize(A, ptr, old_size, new_size, ...)    CFLAT_OPT(cflat_allocator_resize_opt(cflat_allocator(A), (ptr), (old_size), (new_size), (CflatAllocOpt){ .align = cflat_alignof(uptr), __VA_ARGS__ }))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_ALLOCATOR_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_ALLOCATOR_H
+
+#if defined(CFLAT_ALLOCATOR_IMPLEMENTATION)
+
+#include <stddef.h>
+#if defined(OS_WINDOWS)
+#include <malloc.h>
+#endif
+
+static void* cflat__arena_allocator_alloc(void *ctx, usize size, CflatAllocOpt opt) {
+    return cflat_arena_push_opt(ctx, size, opt);
+}
+
+static void* cflat__arena_allocator_resize(void *ctx, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt) {
+    return cflat_arena_extend_opt(ctx, ptr, old_size, new_size, opt);
+}
+
+static void cflat__arena_allocator_free(void *ctx, void *ptr, usize size) {
+    if (cflat_arena_release_large(ctx, ptr)) return;
+    if (ptr && (byte*)ptr + size == cflat_arena_top(ctx)) cflat_arena_pop(ctx, size);
+}
+
+static const CflatAllocatorVtable cflat__arena_allocator_vtable = {
+    .alloc  = cflat__arena_allocator_alloc,
+    .resize = cflat__arena_allocator_resize,
+    .free   = cflat__arena_allocator_free,
+};
+
+CflatAllocator cflat_arena_allocator(CflatArena *arena) {
+    return (CflatAllocator) { .vtable = &cflat__arena_allocator_vtable, .ctx = arena };
+}
+
+CflatArena* cflat_allocator_arena(CflatAllocator allocator) {
+    return allocator.vtable == &cflat__arena_allocator_vtable ? allocator.ctx : NULL;
+}
+
+static bool cflat__libc_is_overaligned(usize align) {
+    return align > cflat_alignof(max_align_t);
+}
+
+static void* cflat__libc_allocator_alloc(void *ctx, usize size, CflatAllocOpt opt) {
+    (void)ctx;
+    if (size == 0) size = 1;
+    void *result;
+    #if defined(OS_WINDOWS)
+    result = _aligned_malloc(size, cflat_max(opt.align, cflat_alignof(max_align_t)));
+    #else
+    if (cflat__libc_is_overaligned(opt.align)) result = aligned_alloc(opt.align, cflat_align_pow2(size, opt.align));
+    else                                       result = malloc(size);
+    #endif
+    if (result && opt.clear) cflat_mem_zero(result, size);
+    return result;
+}
+
+static void cflat__libc_allocator_free(void *ctx, void *ptr, usize size) {
+    (void)ctx; (void)size;
+    #if defined(OS_WINDOWS)
+    _aligned_free(ptr);
+    #else
+    free(ptr);
+    #endif
+}
+
+static void* cflat__libc_allocator_resize(void *ctx, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt) {
+    void *result;
+    #if defined(OS_WINDOWS)
+    (void)ctx;
+    result = _aligned_realloc(ptr, cflat_max(new_size, 1), cflat_max(opt.align, cflat_alignof(max_align_t)));
+    #else
+    if (cflat__libc_is_overaligned(opt.align)) {
+        // realloc only keeps the alignment of malloc
+        result = cflat__libc_allocator_alloc(ctx, new_size, (CflatAllocOpt){ .align = opt.align });
+        if (result && ptr) cflat_mem_copy(result, ptr, cflat_min(old_size, new_size));
+        cflat__libc_allocator_free(ctx, ptr, old_size);
+    } else {
+        result = realloc(ptr, cflat_max(new_size, 1));
+    }
+    #endif
+    if (result && opt.clear && new_size > old_size) cflat_mem_zero((byte*)result + old_size, new_size - old_size);
+    return result;
+}
+
+static const CflatAllocatorVtable cflat__libc_allocator_vtable = {
+    .alloc  = cflat__libc_allocator_alloc,
+    .resize = cflat__libc_allocator_resize,
+    .free   = cflat__libc_allocator_free,
+};
+
+CflatAllocator cflat_libc_allocator(void) {
+    return (CflatAllocator) { .vtable = &cflat__libc_allocator_vtable, .ctx = NULL };
+}
+
+void* cflat_allocator_alloc_opt(CflatAllocator allocator, usize size, CflatAllocOpt opt) {
+    if (opt.align == 0) opt.align = cflat_alignof(uptr);
+    return allocator.vtable->alloc(allocator.ctx, size, opt);
+}
+
+void* cflat_allocator_resize_opt(CflatAllocator allocator, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt) {
+    if (opt.align == 0) opt.align = cflat_alignof(uptr);
+    return allocator.vtable->resize(allocator.ctx, ptr, old_size, new_size, opt);
+}
+
+void cflat_allocator_free(CflatAllocator allocator, void *ptr, usize size) {
+    if (ptr == NULL) return;
+    allocator.vtable->free(allocator.ctx, ptr, size);
+}
+
+#endif // CFLAT_ALLOCATOR_IMPLEMENTATION
+#undef CFLAT_ALLOCATOR_IMPLEMENTATION
+
+#if !defined(CFLAT_ALLOCATOR_NO_ALIAS)
+
+#   define Allocator CflatAllocator
+#   define AllocatorVtable CflatAllocatorVtable
+#   define arena_allocator cflat_arena_allocator
+#   define libc_allocator cflat_libc_allocator
+#   define allocator_arena cflat_allocator_arena
+#   define allocator_alloc cflat_allocator_alloc
+#   define allocator_alloc_opt cflat_allocator_alloc_opt
+#   define allocator_resize cflat_allocator_resize
+#   define allocator_resize_opt cflat_allocator_resize_opt
+#   define allocator_free cflat_allocator_free
+
+#endif // CFLAT_ALLOCATOR_NO_ALIAS
@@ -2,37 +2,89 @@
 #define CFLAT_DA_H
 
 #include "CflatArena.h"
+#include "CflatAllocator.h"
 #include "CflatBit.h"
 #include "CflatCore.h"
 #include "CflatSlice.h"
 #include <stdio.h>
 
-#define cflat_slice_resize(ARENA, DA, HINT)                                                                                      \
+// Grows the slice so it can hold HINT elements, doubling its capacity at least
+#define cflat_slice_resize(ALLOCATOR, DA, HINT)                                                                                  \
     do {                                                                                                                         \
-        const usize element_size = sizeof(*(DA)->data);                                                                          \
-        const usize element_alignment = cflat_alignof(max_align_t);                                                              \
-        const CflatAllocOpt alloc_opt = (CflatAllocOpt) { .align = element_alignment, .clear = false };                          \
-        if ((HINT) > (DA)->capacity) {                                                                                           \
-            const usize old_size = (DA)->capacity * element_size;                                                                \
-            if ((DA)->capacity == 0) (DA)->capacity = 4;                                                                         \
-            while ((HINT) > (DA)->capacity) (DA)->capacity *= 2;                                                                 \
-            const usize new_size = cflat_next_pow2_u64((DA)->capacity * element_size);                                           \
-            (DA)->data = cflat_arena_extend_opt((ARENA), (DA)->data, old_size, new_size , alloc_opt);                            \
+        const usize cflat__hint = (HINT);                                                                                        \
+        if (cflat__hint > (DA)->capacity) {                                                                                      \
+            cflat__slice_grow(cflat_allocator(ALLOCATOR), (DA), sizeof(*(DA)->data),                                             \
+                              cflat__slice_grown_capacity((DA)->capacity, cflat__hint));                                         \
         }                                                                                                                        \
     } while (0)
 
-#define cflat_slice_append(ARENA, DA, VAL)                                                                                       \
+// Grows the capacity of the slice to exactly CAPACITY elements, nothing happens if it already holds that many
+#define cflat_slice_reserve_exact(ALLOCATOR, DA, CAPACITY)                                                                       \
+    cflat__slice_grow(cflat_allocator(ALLOCATOR), (DA), sizeof(*(DA)->data), (CAPACITY))
+
+// Appends COUNT elements from SRC with at most one grow and one copy, SRC may point into the slice
+#define cflat_slice_append_many(ALLOCATOR, DA, SRC, COUNT)                                                                       \
+    cflat__slice_append_many(cflat_allocator(ALLOCATOR), (DA),                                                                   \
+                             sizeof(*(DA)->data) + 0 * sizeof((DA)->data[0] = (SRC)[0]), (SRC), (COUNT))
+
+// Appends every element of the slice SRC_SLICE
+#define cflat_slice_extend(ALLOCATOR, DA, SRC_SLICE)                                                                             \
+    cflat_slice_append_many((ALLOCATOR), (DA), (SRC_SLICE).data, (SRC_SLICE).length)
+
+#define cflat_slice_append(ALLOCATOR, DA, VAL)                                                                                   \
     do {                                                                                                                         \
-        cflat_slice_resize((ARENA), (DA), (DA)->length + 1);                                                                     \
+        cflat_slice_resize((ALLOCATOR), (DA), (DA)->length + 1);                                                                 \
         (DA)->data[(DA)->length++] = (VAL);                                                                                      \
     } while (0)
 
-#define cflat_slice_emplace(ARENA, DA, ...)                                                                                      \
+#define cflat_slice_emplace(ALLOCATOR, DA, ...)                                                                                  \
     do {                                                                                                                         \
-        cflat_slice_resize((ARENA), (DA), (DA)->length + 1);                                                                     \
+        cflat_slice_resize((ALLOCATOR), (DA), (DA)->length + 1);                                                                 \
         (DA)->data[(DA)->length++] = ((cflat_typeof(*(DA)->data)){__VA_ARGS__});                                                 \
     } while (0)
 
+// Gives the memory of the slice back to the allocator it was grown with
+#define cflat_slice_delete(ALLOCATOR, DA)                                                                                        \
+    do {                                                                                                                         \
+        cflat_allocator_free(cflat_allocator(ALLOCATOR), (DA)->data, (DA)->capacity * sizeof(*(DA)->data));                      \
+        (DA)->data = NULL;                                                                                                       \
+        (DA)->length = (DA)->capacity = 0;                                                                                       \
+    } while (0)
+
+#define cflat_small_slice_is_inline(SS) ((SS)->data == NULL || (void*)(SS)->data == (void*)(SS)->inline_data)
+
+// Grows a CFLAT_SMALL_SLICE so it can hold HINT elements, it stays inline while they fit
+#define cflat_small_slice_resize(ALLOCATOR, SS, HINT)                                                                            \
+    do {                                                                                                                         \
+        const usize cflat__hint = (HINT);                                                                                        \
+        if (cflat__hint > (SS)->capacity) {                                                                                      \
+            cflat__small_slice_grow(cflat_allocator(ALLOCATOR), (SS), (SS)->inline_data, CFLAT_ARRAY_SIZE((SS)->inline_data),    \
+                                    sizeof(*(SS)->data), cflat__hint);                                                           \
+        }                                                                                                                        \
+    } while (0)
+
+#define cflat_small_slice_append(ALLOCATOR, SS, VAL)                                                                             \
+    do {                                                                                                                         \
+        cflat_small_slice_resize((ALLOCATOR), (SS), (SS)->length + 1);                                                           \
+        (SS)->data[(SS)->length++] = (VAL);                                                                                      \
+    } while (0)
+
+#define cflat_small_slice_emplace(ALLOCATOR, SS, ...)                                                                            \
+    do {                                                                                                                         \
+        cflat_small_slice_resize((ALLOCATOR), (SS), (SS)->length + 1);                                                           \
+        (SS)->data[(SS)->length++] = ((cflat_typeof(*(SS)->data)){__VA_ARGS__});                                                 \
+    } while (0)
+
+// Gives the memory back if the slice spilled out of its inline storage, it is empty and inline afterwards
+#define cflat_small_slice_delete(ALLOCATOR, SS)                                                                                  \
+    do {                                                                                                                         \
+        if (!cflat_small_slice_is_inline(SS)) {                                                                                  \
+            cflat_allocator_free(cflat_allocator(ALLOCATOR), (SS)->data, (SS)->capacity * sizeof(*(SS)->data));                  \
+        }                                                                                                                        \
+        (SS)->data = NULL;                                                                                                       \
+        (SS)->length = (SS)->capacity = 0;                                                                                       \
+    } while (0)
+
 #define cflat_slice_append_fixed(DA, VAL)                                                                                        \
     do {                                                                                                                         \
         (void)cflat_bounds_check((DA)->length, (DA)->capacity);                                                                  \
@@ -59,9 +111,9 @@
         }                                                                                                                        \
     } while(0)
 
-#define cflat_slice_insert(ARENA, SLICE, INDEX, VAL)                                                                             \
+#define cflat_slice_insert(ALLOCATOR, SLICE, INDEX, VAL)                                                                         \
     do {                                                                                                                         \
-            cflat_slice_resize((ARENA), (SLICE), (SLICE)->length + 1);                                                           \
+            cflat_slice_resize((ALLOCATOR), (SLICE), (SLICE)->length + 1);                                                       \
             cflat_mem_move(&(SLICE)->data[(INDEX) + 1], &(SLICE)->data[(INDEX)],                                                 \
                     ((SLICE)->length - (INDEX)) * sizeof(*(SLICE)->data));                                                       \
             (SLICE)->data[(INDEX)] = (VAL);                                                                                      \
@@ -80,8 +132,17 @@
 #ifndef CFLAT_DA_NO_ALIAS
 #   define slice_resize cflat_slice_resize
 #   define slice_append cflat_slice_append
+#   define slice_append_many cflat_slice_append_many
+#   define slice_extend cflat_slice_extend
+#   define slice_reserve_exact cflat_slice_reserve_exact
+#   define small_slice_is_inline cflat_small_slice_is_inline
+#   define small_slice_resize cflat_small_slice_resize
+#   define small_slice_append cflat_small_slice_append
+#   define small_slice_emplace cflat_small_slice_emplace
+#   define small_slice_delete cflat_small_slice_delete
 #   define slice_remove cflat_slice_remove
 #   define slice_insert cflat_slice_insert
+#   define slice_delete cflat_slice_delete
 #   define slice_append_fixed cflat_slice_append_fixed
 #   define slice_insert_fixed cflat_slice_insert_fixed
 #   define mem_move cflat_mem_move
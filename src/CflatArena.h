@@ -12,47 +12,184 @@
 
 #define CFLAT_DEFAULT_RESERVE_SIZE KiB(64)
 #define CFLAT_DEFAULT_COMMIT_SIZE  KiB(4)
+#define CFLAT_DEFAULT_GROWTH_CAP   GiB(1)
+#define CFLAT_DEFAULT_COMMIT_CHUNK KiB(64)
+#define CFLAT_DEFAULT_COMMIT_CAP   MiB(256)
+
+// Per thread scratch arenas, mapped on first use and grown like any other arena
+#ifndef CFLAT_SCRATCH_ARENA_COUNT
+#define CFLAT_SCRATCH_ARENA_COUNT      2
+#endif
+#ifndef CFLAT_SCRATCH_ARENA_RESERVE
+#define CFLAT_SCRATCH_ARENA_RESERVE    MiB(64)
+#endif
+#ifndef CFLAT_SCRATCH_ARENA_KEEP_WARM
+#define CFLAT_SCRATCH_ARENA_KEEP_WARM  KiB(64)
+#endif
+#ifndef CFLAT_SCRATCH_ARENA_HYSTERESIS
+#define CFLAT_SCRATCH_ARENA_HYSTERESIS KiB(256)
+#endif
+
+// Address space a memory mapped arena can grow its file into
+#ifndef CFLAT_ARENA_MAPPED_RESERVE
+#define CFLAT_ARENA_MAPPED_RESERVE ((usize)GiB(1) * 64)
+#endif
+// Page ranges written since the last flush a memory mapped arena remembers, more than that are merged
+#define CFLAT_ARENA_UNFLUSHED_RANGES 16
+
+// Free nodes are bucketed by their reserve, each power of two from 4 KiB is split in 4 classes
+#define CFLAT_ARENA_FREE_BUCKETS       64
+#define CFLAT__ARENA_FREE_BUCKET_SHIFT 12
+#define CFLAT__ARENA_FREE_BUCKET_SPLIT 2
+#define CFLAT__ARENA_FREE_SCAN         4
 
 cflat_enum(CflatArenaFlags, u64) {
-    CFLAT_ARENA_OWNS_MEMORY  = 1 << 0,
-    CFLAT_ARENA_FIXED_SIZE   = 1 << 1,
-    CFLAT_MEMORY_MAPPED      = 1 << 2,
+    CFLAT_ARENA_OWNS_MEMORY              = 1 << 0,
+    CFLAT_ARENA_FIXED_SIZE               = 1 << 1,
+    CFLAT_MEMORY_MAPPED                  = 1 << 2,
+    CFLAT_ARENA_HUGE_PAGES               = 1 << 3,
+    CFLAT_ARENA_TRANSPARENT_HUGE_PAGES   = 1 << 4,
+    CFLAT_ARENA_PREFAULT                 = 1 << 5,
+    CFLAT_ARENA_SHARED                   = 1 << 6,
+    CFLAT_ARENA_RESTORED                 = 1 << 7, // Node mapped back from a snapshot, its image is a private file mapping
+};
+
+/*
+How the reserve of a new node is picked when the arena overflows
+A node is always at least as big as the request that overflowed
+*/
+cflat_enum(CflatArenaGrowth, u8) {
+    CFLAT_ARENA_GROW_DOUBLE = 0, // Twice the reserve of the current node, up to growth_cap
+    CFLAT_ARENA_GROW_FIXED  = 1, // The reserve of the first node
+    CFLAT_ARENA_GROW_EXACT  = 2, // Just enough for the request
 };
 
+/*
+Counters describing what an arena has been doing
+The fields marked as counters are only tracked when CFLAT_ARENA_STATS is enabled and read 0 otherwise
+The rest are taken from the arena nodes when cflat_arena_stats is called
+@param requested:       counter, bytes asked for by pushes
+@param consumed:        counter, bytes the pushes moved the nodes by, the difference to requested is alignment padding
+@param node_count:      nodes holding allocations
+@param free_node_count: retired nodes waiting to be reused
+@param reserved:        bytes of address space held by the nodes
+@param committed:       bytes of the nodes backed by memory
+@param commit_calls:    counter, commits (mprotect/VirtualAlloc) issued
+@param decommit_calls:  counter, decommits and node releases issued while trimming
+@param peak_pos:        counter, highest position the arena reached
+@param extend_in_place: counter, cflat_arena_extend calls that grew the region where it was
+@param extend_copies:   counter, cflat_arena_extend calls that had to move the region
+@param large_count:     allocations living in their own mapping, see large_threshold
+@param large_bytes:     bytes mapped for them
+*/
+typedef struct cflat_arena_stats {
+    usize requested;
+    usize consumed;
+    usize node_count;
+    usize free_node_count;
+    usize reserved;
+    usize committed;
+    usize commit_calls;
+    usize decommit_calls;
+    usize peak_pos;
+    usize extend_in_place;
+    usize extend_copies;
+    usize large_count;
+    usize large_bytes;
+} CflatArenaStats;
+
 #define cflat_has_flag(FLAGS, FLAG)   (((FLAGS) & (FLAG)) != 0)
 #define cflat_set_flag(FLAGS, FLAG)   ((FLAGS) |= (FLAG))
 #define cflat_clear_flag(FLAGS, FLAG) ((FLAGS) &= ~(FLAG))
 
-typedef struct cflat_arena {
-    struct cflat_arena_node *curr;
-    struct cflat_arena_node *free;
-    CflatArenaFlags flags;
-    usize pos;
-} CflatArena;
+/*
+Record of an allocation served by its own mapping, pushed in the arena right before the allocation is made
+Popping the arena past the record unmaps the allocation
+*/
+typedef struct cflat_arena_large {
+    struct cflat_arena_large *prev;
+    byte *data;
+    usize size; // Mapped bytes, 0 once released
+    usize pos;  // Arena position before the record was pushed
+} CflatArenaLarge;
 
+/*
+Header at the start of every node, positions are offsets from it
+*/
 typedef struct cflat_arena_node {
-    CflatArena _arena;
     struct cflat_arena_node *prev;
+    CflatArenaFlags flags;
+    usize page_size;
     usize pos;
     usize res;
     usize cmt;
-    byte data[];
+    usize dirty; // Everything past dirty has never been handed out and is still zero from the os
 } CflatArenaNode;
 
+// The arena lives in its first node, only that one pays for the fields below the node header
+typedef struct cflat_arena {
+    CflatArenaNode _node;
+    struct cflat_arena_node *curr;
+    struct cflat_arena_node *free[CFLAT_ARENA_FREE_BUCKETS];
+    u64 free_mask;
+    CflatArenaFlags flags;
+    usize pos;
+    usize page_size;
+    usize committed;
+    usize keep_warm;
+    usize hysteresis;
+    usize reserve_size;
+    usize commit_size;
+    usize commit_chunk;
+    usize commit_cap;
+    usize growth_cap;
+    CflatArenaGrowth growth;
+    usize large_threshold;
+    CflatArenaLarge *large;
+    struct cflat_arena_file *file;
+    u32 file_magic;       // Only set in memory mapped arenas, checked when the file is opened again
+    u32 file_header_size; // sizeof(CflatArena) of the build that wrote the file, it moves with CFLAT_ARENA_STATS and the free buckets
+    #if CFLAT_ARENA_STATS
+    CflatArenaStats stats;
+    struct cflat_arena *live_prev, *live_next;
+    #endif
+} CflatArena;
+
 typedef struct cflat_arena_scope {
     CflatArena *arena;
     usize pos;
 } CflatTempArena;
 
 /*
-@param reserve:    how much memory should reserved but not yet commited
-@param commit:     how much memory should be commited
-@param fixed_size: weather or not the arena can gorw by allocate new arena nodes
+@param reserve:      how much memory should reserved but not yet commited
+@param commit:       how much memory should be commited
+@param commit_chunk: smallest step a node commits by when a push runs past its committed memory, 0 for CFLAT_DEFAULT_COMMIT_CHUNK
+@param commit_cap:   largest step, steps double with what the node already committed up to it, 0 for CFLAT_DEFAULT_COMMIT_CAP
+@param fixed_size:   weather or not the arena can gorw by allocate new arena nodes
+@param page_size:    page size to back the arena with, 0 for the os default, MiB(2) or GiB(1) for huge pages
+                     tries MAP_HUGETLB first and falls back to transparent huge pages, see cflat_arena_page_size
+@param keep_warm:    committed bytes kept after clear/pop, the rest is returned to the os, 0 keeps everything
+@param hysteresis:   committed bytes tolerated above keep_warm before anything is returned to the os
+@param growth:       @inherit(CflatArenaGrowth)
+@param growth_cap:   largest reserve CFLAT_ARENA_GROW_DOUBLE will pick, 0 for CFLAT_DEFAULT_GROWTH_CAP
+@param prefault:     fault in every page as it is committed, moving the first touch page faults out of the pushes
+@param large_threshold: pushes of at least this many bytes get their own mapping instead of space in the nodes,
+                     extending them remaps in place of copying, 0 disables it
+                     popping a large allocation only pops its record, unwind them with temp scopes, set_pos or clear
 */
 typedef struct cflat_arena_new_opt {
     usize reserve;
     usize commit;
+    usize commit_chunk;
+    usize commit_cap;
     bool fixed_size;
+    usize page_size;
+    usize keep_warm;
+    usize hysteresis;
+    CflatArenaGrowth growth;
+    usize growth_cap;
+    bool prefault;
+    usize large_threshold;
 } CflatArenaNewOpt;
 
 /*
@@ -81,7 +218,12 @@ cflat_enum(CflatPermission, u8) {
 };
 
 /*
- Allocates a new arena in a memory mapped file
+ Allocates a new arena in a memory mapped file, or reopens the one saved in it
+ With CFLAT_PERMISSION_WRITE the file is mapped shared, it grows as the arena does (up to CFLAT_ARENA_MAPPED_RESERVE)
+ and what is pushed reaches the file on cflat_arena_flush and cflat_arena_delete
+ Without it the mapping is a private copy of the file and can't grow
+ Pointers into the arena stay valid while it grows, store offsets from the arena in the file to find things after a reopen
+ Returns NULL when the file is not empty and was not written by an arena built with the same header layout
  @param filepath:  path to the file, relative or absolute
  @param size_hint: minimum size in bytes to allocate for the memory mapped region  
  @param mode:      permissions of the memory mapped region
@@ -89,9 +231,25 @@ cflat_enum(CflatPermission, u8) {
 CFLAT_DEF CflatArena*    cflat_arena_memory_mapped   (const char *filepath, usize size_hint, CflatPermission mode                  );
 
 /*
- Initializes a new arena in a preallocated region of memory
+ Allocates a fixed size arena in shared memory that other processes can map, or maps the one already called name
+ Every process maps it at the address its creator got, so pointers into it mean the same thing everywhere,
+ mapping fails when that address is taken in the calling process
+ Pushes are not synchronized, allocate from one process at a time and hand the others offsets, see CflatChannel
+ @param name: name of the shared memory object ("/name" on posix), NULL for an anonymous one only reachable through fork
+ @param size: size in bytes of the arena, ignored when it already exists
+*/
+CFLAT_DEF CflatArena*    cflat_arena_shared          (const char *name, usize size                                                 );
+
+/*
+ Removes the name of a shared arena, the memory goes away once every process deleted its arena
+ @param name: name the arena was created with
+*/
+CFLAT_DEF bool           cflat_arena_shared_unlink   (const char *name                                                             );
+
+/*
+ Initializes a new arena in a preallocated region of memory, the arena is at the start of it
  @param mem:  pointer to the memory region
- @param size: size of the memory region
+ @param size: size of the memory region, at least sizeof(CflatArena)
 */
 CFLAT_DEF CflatArena*    cflat_arena_init            (void *mem, usize size                                                        );
 
@@ -140,6 +298,14 @@ For each node on the arena
 */
 CFLAT_DEF void           cflat_arena_delete          (CflatArena *arena                                                            );
 
+/*
+Returns the committed memory above keep bytes to the os right away, whatever keep_warm says
+What is pushed stays, free nodes are released first and then the unused tails of the nodes
+@param arena: the arena
+@param keep:  committed bytes to keep
+*/
+CFLAT_DEF void           cflat_arena_trim            (CflatArena *arena, usize keep                                                );
+
 /*
 Returns a pointer the end of the arena
 The pointer is outside the adress range of the arena
@@ -147,6 +313,28 @@ The pointer is outside the adress range of the arena
 */
 CFLAT_DEF void*          cflat_arena_top             (CflatArena *arena                                                            );
 
+/*
+Returns the page size the arena actually got from the os
+Commits and node sizes are multiples of it
+@param arena: the arena
+*/
+CFLAT_DEF usize          cflat_arena_page_size       (CflatArena *arena                                                            );
+
+/*
+Returns the counters of the arena, see CflatArenaStats
+@param arena: the arena
+*/
+CFLAT_DEF CflatArenaStats cflat_arena_stats          (CflatArena *arena                                                            );
+
+/*
+Prints the stats of every arena that was created and not yet deleted
+Only the arenas created while CFLAT_ARENA_STATS is enabled are tracked
+Arenas made with cflat_arena_init are left out, their memory can go away without them being deleted
+So are shared and memory mapped arenas, the links would be written to memory that outlives the process
+@param file: where to print, stderr if NULL
+*/
+CFLAT_DEF void           cflat_arena_stats_dump      (FILE *file                                                                   );
+
 /*
 Takes a region of memory inside the arena and returns a bigger one containing the same information 
 The region can be the same if theres enough space in the arena but that is not a garantee
@@ -159,12 +347,68 @@ The region can be the same if theres enough space in the arena but that is not a
 */
 CFLAT_DEF void*          cflat_arena_extend_opt      (CflatArena *arena, void *ptr, usize oldsize, usize newsize, CflatAllocOpt opt);
 
+/*
+Writes the pages of a memory mapped arena that changed since the last flush to the file and waits for them
+Only pushed memory is tracked, memory modified after it was pushed has to be marked with cflat_arena_mark_dirty
+Does nothing for arenas that aren't memory mapped
+@param arena: the arena
+@return:      false if the os failed to write something
+*/
+CFLAT_DEF bool           cflat_arena_flush           (CflatArena *arena                                                            );
+
+/*
+Marks a region of a memory mapped arena to be written by the next flush
+@param arena: the arena
+@param ptr:   start of the region
+@param size:  size of the region in bytes
+*/
+CFLAT_DEF void           cflat_arena_mark_dirty      (CflatArena *arena, const void *ptr, usize size                               );
+
+/*
+Writes the nodes in the curr chain of the arena to a file in one pass, see cflat_arena_restore
+Free nodes are left out, arenas with large allocations or backed by a file can't be snapshotted
+@param arena: the arena
+@param path:  file to write, replaced if it exists
+@return:      false if the arena can't be snapshotted or the write failed
+*/
+CFLAT_DEF bool           cflat_arena_snapshot        (CflatArena *arena, const char *path                                          );
+
+/*
+Maps a snapshot back as a copy on write arena, pages are only read from the file when touched
+Every node is put back at the address it had, raw pointers into the arena stay valid and nothing has to be fixed up
+That also means the snapshot can only be restored while those addresses are free, typically at the start of a process
+@param path: file written by cflat_arena_snapshot
+@return:     the arena, NULL if the file is not a snapshot taken with the same arena layout or an address is taken
+*/
+CFLAT_DEF CflatArena*    cflat_arena_restore         (const char *path                                                             );
+
+/*
+Unmaps a large allocation without waiting for the arena to be popped past it
+@param arena: the arena
+@param ptr:   the allocation
+@return:      false if ptr is not a large allocation of the arena
+*/
+CFLAT_DEF bool           cflat_arena_release_large   (CflatArena *arena, void *ptr                                                 );
+
 CFLAT_DEF bool           cflat_arena_try_push_opt    (CflatArena *arena, usize size, void **mem, CflatAllocOpt opt                 );
 CFLAT_DEF CflatTempArena cflat_arena_temp_begin      (CflatArena *arena                                                            );
 CFLAT_DEF void           cflat_arena_temp_end        (CflatTempArena temp_arena                                                    );
+
+/*
+Returns a scratch arena of the calling thread that is not one of the conflicts
+There are CFLAT_SCRATCH_ARENA_COUNT of them per thread, each reserves CFLAT_SCRATCH_ARENA_RESERVE the first time it is used
+and grows past it when needed, once it is dropped back to empty everything above CFLAT_SCRATCH_ARENA_KEEP_WARM is returned to the os
+@param opt: @inherit(CflatScratchArenaScopeOpt)
+*/
 CFLAT_DEF CflatTempArena cflat_get_scratch_arena_opt (CflatScratchArenaScopeOpt opt                                                );
 CFLAT_DEF void           cflat_drop_scratch_arena    (const CflatTempArena temp_arena                                              );
 
+/*
+Deletes the scratch arenas of the calling thread, they are mapped again if used afterwards
+Threads that exit have theirs deleted on the way out
+*/
+CFLAT_DEF void           cflat_release_scratch_arenas(void                                                                         );
+
 #define cflat_arena_new(...)                              CFLAT_OPT(cflat_arena_new_opt((CflatArenaNewOpt){ .reserve = CFLAT_DEFAULT_RESERVE_SIZE, .commit = CFLAT_DEFAULT_COMMIT_SIZE, __VA_ARGS__ }))
 #define cflat_arena_push(a, size, ...)                    CFLAT_OPT(cflat_arena_push_opt((a), (size), (CflatAllocOpt){ .align = cflat_alignof(uptr), __VA_ARGS__}))
 #define cflat_arena_try_push(a, size, mem, ...)           CFLAT_OPT(cflat_arena_try_push_opt((a), (size), (mem), (CflatAllocOpt){ .align = cflat_alignof(uptr), __VA_ARGS__}))
@@ -181,6 +425,29 @@ CFLAT_DEF void           cflat_drop_scratch_arena    (const CflatTempArena temp_
 
 #define cflat_arena_push_ptr(ARENA, ...) (cflat_arena_push((ARENA), sizeof(void*), __VA_ARGS__))
 
+/*
+Pointer stored as an offset from a base address, the arena it points into
+Structures made of them stay valid wherever the arena gets mapped, so a memory mapped arena can be used right after it is opened
+Offset 0 is NULL, nothing but the arena header can live there
+*/
+#define CflatRelPtr(T) union { isize offset; T *type_tag; }
+
+#define cflat_rel_set(BASE, REL, PTR) ((REL).offset = cflat__rel_offset((BASE), (PTR)))
+#define cflat_rel_get(BASE, REL)      ((cflat_typeof((REL).type_tag))cflat__rel_resolve((BASE), (REL).offset))
+#define cflat_rel_is_null(REL)        ((REL).offset == 0)
+
+static inline isize cflat__rel_offset(const void *base, const void *ptr) {
+    return ptr ? (isize)((const byte*)ptr - (const byte*)base) : 0;
+}
+
+static inline void* cflat__rel_resolve(const void *base, isize offset) {
+    return offset ? (byte*)base + offset : NULL;
+}
+
+#define cflat_arena_for_each_free_node(ARENA, NODE)                                                                      \
+    for (usize CONCAT(_b, __LINE__) = 0; CONCAT(_b, __LINE__) < CFLAT_ARENA_FREE_BUCKETS; ++CONCAT(_b, __LINE__))           \
+    for (CflatArenaNode *NODE = (ARENA)->free[CONCAT(_b, __LINE__)]; NODE; NODE = NODE->prev)
+
 #define cflat_get_scratch_arena(...) CFLAT_OPT(cflat_get_scratch_arena_opt((CflatScratchArenaScopeOpt) {__VA_ARGS__}))
 
 #define CFLAT_ARRAY_SPLAT(ARRAY) CFLAT_ARRAY_SIZE((ARRAY)), (ARRAY)
@@ -198,7 +465,9 @@ CFLAT_DEF void           cflat_drop_scratch_arena    (const CflatTempArena temp_
 #if ASAN_ENABLED
 #include <sanitizer/asan_interface.h>
 #include <sanitizer/lsan_interface.h>
+# define CFLAT__NO_ASAN __attribute__((no_sanitize_address))
 #else
+# define CFLAT__NO_ASAN
 # define ASAN_POISON_MEMORY_REGION(addr, size)   ((void)(addr), (void)(size))
 # define ASAN_UNPOISON_MEMORY_REGION(addr, size) ((void)(addr), (void)(size))
 #endif
@@ -214,15 +483,44 @@ CFLAT_DEF void           cflat_drop_scratch_arena    (const CflatTempArena temp_
 #if defined(OS_WINDOWS)
 typedef void* HWND;
 #include <memoryapi.h>
+#include <sysinfoapi.h>
 #include <fileapi.h>
 #include <handleapi.h>
 #include <winbase.h>
+#include <fibersapi.h>
+#include <synchapi.h>
 #elif defined(OS_UNIX)
+#include <pthread.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
+#ifndef IOV_MAX
+#define IOV_MAX 1024 // Only defined with _XOPEN_SOURCE, 1024 is what linux and the bsds take
+#endif
 #include <fcntl.h>
 #include <sys/stat.h>
+#if !defined(MAP_FIXED_NOREPLACE)
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
 #endif
 
+static usize cflat__os_page_size(void)
+{
+    static usize page_size = 0;
+    if (page_size == 0) {
+        #if defined(OS_WINDOWS)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        page_size = info.dwPageSize;
+        #elif defined(OS_UNIX)
+        page_size = (usize)sysconf(_SC_PAGESIZE);
+        #else
+        #error Unsupported platform
+        #endif
+    }
+    return page_size;
+}
+
 static void *cflat__os_reserve(usize size)
 {
     #if defined(OS_WINDOWS)
@@ -240,6 +538,61 @@ static void *cflat__os_reserve(usize size)
     #endif
 }
 
+/*
+Reserves size bytes backed by pages of *page_size bytes
+Falls back to transparent huge pages and then to regular pages,
+*page_size and flags are updated with what was actually obtained
+*/
+static void *cflat__os_reserve_pages(usize size, usize *page_size, CflatArenaFlags *flags)
+{
+    const usize os_page_size = cflat__os_page_size();
+    const usize requested = *page_size;
+    *page_size = os_page_size;
+    if (requested <= os_page_size) return cflat__os_reserve(size);
+
+    #if defined(OS_WINDOWS)
+    const usize large_page_size = GetLargePageMinimum();
+    if (large_page_size != 0 && requested >= large_page_size) {
+        // Large pages can't be committed lazily on windows
+        void *result = VirtualAlloc(0, cflat_align_pow2(size, large_page_size), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (result) {
+            *page_size = large_page_size;
+            cflat_set_flag(*flags, CFLAT_ARENA_HUGE_PAGES);
+            return result;
+        }
+    }
+    return cflat__os_reserve(size);
+    #elif defined(OS_UNIX)
+    #if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    const int huge_size_flag = (int)cflat_log2_u64(requested) << MAP_HUGE_SHIFT;
+    void *result = mmap(0, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|huge_size_flag, -1, 0);
+    if (result != MAP_FAILED) {
+        *page_size = requested;
+        cflat_set_flag(*flags, CFLAT_ARENA_HUGE_PAGES);
+        return result;
+    }
+    #endif
+    #if defined(MADV_HUGEPAGE)
+    // Transparent huge pages are pmd sized and only used for pmd aligned ranges
+    const usize thp_size = cflat_min(requested, MiB(2));
+    byte *base = mmap(0, size + thp_size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    byte *aligned = (byte*)cflat_align_pow2((uptr)base, thp_size);
+    if (aligned != base) munmap(base, aligned - base);
+    munmap(aligned + size, (base + size + thp_size) - (aligned + size));
+    if (madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+        *page_size = thp_size;
+        cflat_set_flag(*flags, CFLAT_ARENA_TRANSPARENT_HUGE_PAGES);
+    }
+    return aligned;
+    #else
+    return cflat__os_reserve(size);
+    #endif
+    #else
+    #error Unsupported platform
+    #endif
+}
+
 static bool cflat__os_commit(void *ptr, usize size)
 {
     #if defined(OS_WINDOWS)
@@ -253,8 +606,17 @@ static bool cflat__os_commit(void *ptr, usize size)
     #endif
 }
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-function"
+// Faults in the pages of a committed range, writing back what is read keeps their contents
+CFLAT__NO_ASAN static void cflat__os_prefault(void *ptr, usize size, usize page_size)
+{
+    #if defined(OS_UNIX) && defined(MADV_POPULATE_WRITE)
+    if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0) return;
+    #endif
+    for (volatile byte *page = ptr; page < (byte*)ptr + size; page += page_size) {
+        *page = *page;
+    }
+}
+
 static void cflat__os_decommit(void *ptr, usize size)
 {
     #if defined(OS_WINDOWS)
@@ -266,7 +628,47 @@ static void cflat__os_decommit(void *ptr, usize size)
     #error Unsuported platform
     #endif
 }
-#pragma GCC diagnostic pop
+
+// Dropping pages of a private file mapping reads the file again, they are replaced with anonymous ones instead
+static void cflat__os_decommit_image(void *ptr, usize size)
+{
+    #if defined(OS_UNIX)
+    mmap(ptr, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED|MAP_NORESERVE, -1, 0);
+    #else
+    // Windows reads the image into committed memory, it decommits to zero pages
+    cflat__os_decommit(ptr, size);
+    #endif
+}
+
+#if defined(OS_LINUX) && !defined(MREMAP_MAYMOVE)
+// mremap is only declared with _GNU_SOURCE, libc has it either way
+extern void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...);
+#define MREMAP_MAYMOVE 1
+#endif
+
+static void *cflat__os_map(usize size)
+{
+    #if defined(OS_WINDOWS)
+    return VirtualAlloc(0, size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    #elif defined(OS_UNIX)
+    void *result = mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    return result == MAP_FAILED ? NULL : result;
+    #else
+    #error Unsupported platform
+    #endif
+}
+
+// Grows or shrinks a mapping made by cflat__os_map, moving it if needed, NULL if the os can't remap
+static void *cflat__os_remap(void *ptr, usize old_size, usize new_size)
+{
+    #if defined(OS_LINUX)
+    void *result = mremap(ptr, old_size, new_size, MREMAP_MAYMOVE);
+    return result == MAP_FAILED ? NULL : result;
+    #else
+    (void)ptr; (void)old_size; (void)new_size;
+    return NULL;
+    #endif
+}
 
 static void cflat__os_release(void *ptr, const usize size)
 {
@@ -280,7 +682,32 @@ static void cflat__os_release(void *ptr, const usize size)
     #endif
 }
 
-static void* cflat__os_memory_mapped_file(const char *filepath, usize size_hint, CflatPermission permission) {
+/*
+A file mapped as an arena, lives outside the mapping so nothing in it is persisted
+The mapping sits at the start of reserve bytes of address space and grows into them, so pointers into it stay valid
+*/
+typedef struct cflat_arena_file {
+    #if defined(OS_WINDOWS)
+    HANDLE handle;
+    #else
+    int handle;
+    #endif
+    bool shared;
+    bool empty; // Nothing was in the file before it was opened
+    CflatPermission permission;
+    usize size;
+    usize reserve;
+    usize unflushed_count;
+    struct { usize begin, end; } unflushed[CFLAT_ARENA_UNFLUSHED_RANGES];
+} CflatArenaFile;
+
+/*
+Maps at least size_hint bytes of the file, creating it if needed
+Without CFLAT_PERMISSION_WRITE the mapping is private, changes stay in memory
+Windows maps the file as it is and can't grow it
+*/
+static byte* cflat__os_file_open(CflatArenaFile *file, const char *filepath, usize size_hint) {
+    const CflatPermission permission = file->permission;
     #if defined(OS_WINDOWS)
     DWORD access =
         (permission & CFLAT_PERMISSION_READ  ? GENERIC_READ  : 0) |
@@ -303,170 +730,465 @@ static void* cflat__os_memory_mapped_file(const char *filepath, usize size_hint,
         CloseHandle(file_handle);
         return NULL;
     }
+    file->size = (usize)current_size.QuadPart;
+    file->empty = file->size == 0;
 
-    if ((usize)current_size.QuadPart < size_hint) {
+    if (file->size < size_hint) {
         LARGE_INTEGER new_size;
         new_size.QuadPart = (LONGLONG)size_hint;
         if (!SetFilePointerEx(file_handle, new_size, NULL, FILE_BEGIN) || !SetEndOfFile(file_handle)) {
             CloseHandle(file_handle);
             return NULL;
         }
+        file->size = size_hint;
     }
     
-    DWORD protect = (permission & CFLAT_PERMISSION_WRITE) ? PAGE_READWRITE : PAGE_READONLY;
+    DWORD protect = (permission & CFLAT_PERMISSION_WRITE) ? PAGE_READWRITE : PAGE_WRITECOPY;
     HANDLE map_handle = CreateFileMappingA(file_handle, NULL, protect, 0, 0, NULL);
     if (map_handle == NULL) {
         CloseHandle(file_handle);
         return NULL;
     }
 
-    DWORD map_access =
-        (permission & CFLAT_PERMISSION_READ  ? FILE_MAP_READ  : 0) |
-        (permission & CFLAT_PERMISSION_WRITE ? FILE_MAP_WRITE : 0);
-
+    DWORD map_access = (permission & CFLAT_PERMISSION_WRITE) ? FILE_MAP_WRITE : FILE_MAP_COPY;
     void *result = MapViewOfFile(map_handle, map_access, 0, 0, 0);
 
     CloseHandle(map_handle);
-    CloseHandle(file_handle);
+    file->handle  = file_handle;
+    file->shared  = (permission & CFLAT_PERMISSION_WRITE) != 0;
+    file->reserve = file->size;
+    if (result == NULL) CloseHandle(file_handle);
     return result;
     
     #elif defined(OS_UNIX)
+    const bool shared = (permission & CFLAT_PERMISSION_WRITE) != 0;
+    int prot = PROT_READ | PROT_WRITE; // The arena header is always written to
+    if (permission & CFLAT_PERMISSION_EXECUTE) prot |= PROT_EXEC;
 
-    int flags = (permission & CFLAT_PERMISSION_WRITE) ? O_RDWR : O_RDONLY;
-    int prot = PROT_NONE;
-    if (permission & CFLAT_PERMISSION_READ)     prot |= PROT_READ;
-    if (permission & CFLAT_PERMISSION_WRITE)    prot |= PROT_WRITE;
-    if (permission & CFLAT_PERMISSION_EXECUTE)  prot |= PROT_EXEC;
-    
-    int fd = open(filepath, flags);
+    int fd = open(filepath, shared ? O_RDWR | O_CREAT : O_RDONLY, 0644);
     if (fd == -1) return NULL;
     
     struct stat sb;
     if (fstat(fd, &sb) == -1) { close(fd); return NULL; }
-    
-    void *result = mmap(NULL, cflat_max((off_t)sb.st_size, (off_t)size_hint), prot, MAP_PRIVATE, fd, 0);
-    close(fd);
-    return (result == MAP_FAILED) ? NULL : result;
+    file->size = (usize)sb.st_size;
+    file->empty = file->size == 0;
+
+    if (file->size < size_hint) {
+        // A private mapping past the end of the file would fault, so only shared mappings can grow the file
+        if (!shared || ftruncate(fd, (off_t)size_hint) == -1) { close(fd); return NULL; }
+        file->size = size_hint;
+    }
+
+    file->reserve = cflat_max(file->reserve, file->size);
+    byte *base = mmap(0, file->reserve, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) { close(fd); return NULL; }
+
+    if (mmap(base, file->size, prot, (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, file->reserve);
+        close(fd);
+        return NULL;
+    }
+
+    file->handle = fd;
+    file->shared = shared;
+    return base;
     
     #else
     #error Unsupported platform
     #endif
 }
 
-static void cflat__os_unmap_file(void *ptr, usize size) {
+// Extends the file to size bytes and maps the new tail right after the old one
+static bool cflat__os_file_grow(CflatArenaFile *file, byte *base, usize size) {
+    #if defined(OS_UNIX)
+    if (!file->shared || size > file->reserve) return false;
+    if (ftruncate(file->handle, (off_t)size) == -1) return false;
+    int prot = PROT_READ | PROT_WRITE;
+    if (file->permission & CFLAT_PERMISSION_EXECUTE) prot |= PROT_EXEC;
+    void *tail = mmap(base + file->size, size - file->size, prot, MAP_SHARED|MAP_FIXED, file->handle, (off_t)file->size);
+    if (tail == MAP_FAILED) return false;
+    file->size = size;
+    return true;
+    #else
+    (void)file; (void)base; (void)size;
+    return false;
+    #endif
+}
+
+static void cflat__os_file_close(CflatArenaFile *file, byte *base) {
     #if defined(OS_WINDOWS)
-    (void)size;
-    UnmapViewOfFile(ptr);
+    UnmapViewOfFile(base);
+    CloseHandle(file->handle);
     #elif defined(OS_UNIX)
-    munmap(ptr, size);
+    munmap(base, file->reserve);
+    close(file->handle);
     #else
     #error Unsupported platform
     #endif
 }
 
-static void  cflat__os_flush_mapped_file(void *ptr, usize size) {
+static bool cflat__os_flush_mapped_file(void *ptr, usize size) {
     #if defined(OS_WINDOWS)
-    FlushViewOfFile(ptr, size);
+    return FlushViewOfFile(ptr, size) != 0;
     #elif defined(OS_UNIX)
-    msync(ptr, size, MS_SYNC);
+    return msync(ptr, size, MS_SYNC) == 0;
     #else
     #error Unsupported platform
     #endif
 }
 
-static bool cflat__os_file_exists(const char *filepath) {
+/*
+Maps the shared memory object name, anonymous shared memory when name is NULL, creating it with size bytes if needed
+An existing object is mapped where its creator mapped it, NULL if it can't be or its creator is still setting it up
+*/
+static byte* cflat__os_shared_open(const char *name, usize size) {
     #if defined(OS_WINDOWS)
-    DWORD attribs = GetFileAttributesA(filepath);
-    return (attribs != INVALID_FILE_ATTRIBUTES) && !(attribs & FILE_ATTRIBUTE_DIRECTORY);
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((u64)size >> 32), (DWORD)size, name);
+    if (mapping == NULL) return NULL;
+    byte *base = NULL;
+    if (GetLastError() != ERROR_ALREADY_EXISTS) {
+        base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    } else {
+        CflatArena *header = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(CflatArena));
+        if (header) {
+            void *address = header->curr;
+            const usize res = header->_node.res;
+            UnmapViewOfFile(header);
+            if (res) base = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, res, address);
+        }
+    }
+    // The views keep the object alive
+    CloseHandle(mapping);
+    return base;
+
     #elif defined(OS_UNIX)
-    struct stat buffer;
-    return (stat(filepath, &buffer) == 0) && S_ISREG(buffer.st_mode);
+    const int prot = PROT_READ | PROT_WRITE;
+    if (name == NULL) {
+        byte *base = mmap(0, size, prot, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+        return base == MAP_FAILED ? NULL : base;
+    }
+
+    byte *base = NULL;
+    int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (fd != -1) {
+        if (ftruncate(fd, (off_t)size) == 0) {
+            base = mmap(0, size, prot, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) base = NULL;
+        }
+        if (base == NULL) shm_unlink(name);
+    }
+    else if ((fd = shm_open(name, O_RDWR, 0600)) != -1) {
+        // The header is still zeroed while the creator sets it up
+        CflatArena header;
+        if (pread(fd, &header, sizeof(header), 0) == (isize)sizeof(header) && header._node.res != 0) {
+            void *address = header.curr;
+            base = mmap(address, header._node.res, prot, MAP_SHARED|MAP_FIXED_NOREPLACE, fd, 0);
+            if (base == MAP_FAILED) base = NULL;
+            // Kernels without MAP_FIXED_NOREPLACE take the address as a hint
+            else if (base != address) {
+                munmap(base, header._node.res);
+                base = NULL;
+            }
+        }
+    }
+
+    // The mapping keeps the object alive
+    if (fd != -1) close(fd);
+    return base;
+
     #else
     #error Unsupported platform
     #endif
 }
 
-static void cflat__node_init(CflatArenaNode *node, CflatArenaFlags flags, const usize res, const usize cmt) {
+static void cflat__os_shared_close(void *base, usize size) {
+    #if defined(OS_WINDOWS)
+    (void)size;
+    UnmapViewOfFile(base);
+    #elif defined(OS_UNIX)
+    munmap(base, size);
+    #else
+    #error Unsupported platform
+    #endif
+}
+
+#if CFLAT_ARENA_STATS
+#include <stdatomic.h>
+
+#define CFLAT__ARENA_STAT(...) __VA_ARGS__
+
+// Every arena that has not been deleted, linked through live_prev/live_next
+static CflatArena *cflat__live_arenas = NULL;
+static atomic_flag cflat__live_arenas_lock = ATOMIC_FLAG_INIT;
+
+static void cflat__live_arenas_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&cflat__live_arenas_lock, memory_order_acquire)) cflat_pause();
+}
+
+static void cflat__live_arenas_release(void) {
+    atomic_flag_clear_explicit(&cflat__live_arenas_lock, memory_order_release);
+}
+
+static void cflat__arena_track(CflatArena *arena) {
+    cflat__live_arenas_acquire();
+    arena->live_prev = NULL;
+    arena->live_next = cflat__live_arenas;
+    if (cflat__live_arenas) cflat__live_arenas->live_prev = arena;
+    cflat__live_arenas = arena;
+    cflat__live_arenas_release();
+}
+
+static void cflat__arena_untrack(CflatArena *arena) {
+    cflat__live_arenas_acquire();
+    if (arena->live_prev) arena->live_prev->live_next = arena->live_next;
+    else if (cflat__live_arenas == arena) cflat__live_arenas = arena->live_next;
+    if (arena->live_next) arena->live_next->live_prev = arena->live_prev;
+    arena->live_prev = arena->live_next = NULL;
+    cflat__live_arenas_release();
+}
+#else
+#define CFLAT__ARENA_STAT(...)
+#define cflat__arena_track(arena)   ((void)(arena))
+#define cflat__arena_untrack(arena) ((void)(arena))
+#endif
+
+static void cflat__node_init(CflatArenaNode *node, CflatArenaFlags flags, const usize res, const usize cmt, const usize page_size) {
     ASAN_UNPOISON_MEMORY_REGION(node, sizeof(*node));
     *node = (CflatArenaNode) {
-        ._arena = {
-            .curr = node,
-            .free = NULL,
-            .pos = 0,
-            .flags = flags,
-        },
+        .flags = flags,
+        .page_size = page_size,
         .pos = sizeof(CflatArenaNode),
         .res = res,
         .cmt = cmt,
+        .dirty = cflat_has_flag(flags, CFLAT_ARENA_OWNS_MEMORY) ? sizeof(CflatArenaNode) : res,
+    };
+}
+
+static inline CflatArenaNode* cflat__arena_owner(CflatArena *arena) {
+    return &arena->_node;
+}
+
+// Where pushes start in node, past the arena in the node holding it
+static inline usize cflat__node_begin(const CflatArena *arena, const CflatArenaNode *node) {
+    return node == &arena->_node ? sizeof(CflatArena) : sizeof(CflatArenaNode);
+}
+
+// Makes node the first node of a new arena, the rest of the arena goes right after the node header
+static CflatArena* cflat__node_hold_arena(CflatArenaNode *node) {
+    cflat_assert(node->res >= sizeof(CflatArena));
+    CflatArena *arena = (CflatArena*)node;
+    ASAN_UNPOISON_MEMORY_REGION(arena, sizeof(*arena));
+    *arena = (CflatArena) {
+        ._node = *node,
+        .curr = node,
+        .pos = 0,
+        .flags = node->flags,
+        .page_size = node->page_size,
+        .committed = node->cmt,
+        .reserve_size = node->res,
+        .commit_size = node->cmt,
+        .commit_chunk = CFLAT_DEFAULT_COMMIT_CHUNK,
+        .commit_cap = CFLAT_DEFAULT_COMMIT_CAP,
+        .growth_cap = CFLAT_DEFAULT_GROWTH_CAP,
+        .large_threshold = 0,
+        .large = NULL,
     };
+    arena->_node.pos = sizeof(CflatArena);
+    arena->_node.dirty = cflat_max(arena->_node.dirty, sizeof(CflatArena));
+    return arena;
 }
 
 CflatArena* cflat_arena_init(void *mem, const usize size) {
-    cflat__node_init(mem, 0, size, size);
-    return &((CflatArenaNode*)mem)->_arena;
+    cflat__node_init(mem, 0, size, size, cflat__os_page_size());
+    // Not tracked, the caller owns the memory and may drop it without deleting the arena
+    return cflat__node_hold_arena(mem);
 }
 
-CflatArena* cflat_arena_new_opt(CflatArenaNewOpt opt) {
+static CflatArenaNode* cflat__arena_node_new(CflatArenaNewOpt opt) {
 
     cflat_assert(opt.reserve >= opt.commit);
-    const usize page_size = 4096;
-    const usize reserve_size = cflat_align_pow2(opt.reserve, page_size);
+    cflat_assert(opt.page_size == 0 || cflat_is_pow2(opt.page_size));
+    CflatArenaFlags flags = CFLAT_ARENA_OWNS_MEMORY;
+    usize page_size = cflat_align_pow2(opt.page_size, cflat__os_page_size());
+    usize reserve_size = cflat_align_pow2(opt.reserve, cflat_max(page_size, cflat__os_page_size()));
+    CflatArenaNode* node = cflat__os_reserve_pages(reserve_size, &page_size, &flags);
+    cflat_assert(node && "Bad alloc!");
+    reserve_size = cflat_align_pow2(reserve_size, page_size);
     const usize commit_size = cflat_align_pow2(opt.commit, page_size);
-    CflatArenaNode* node = cflat__os_reserve(reserve_size);
     VALGRIND_MALLOCLIKE_BLOCK(node, reserve_size, 0, false);
 
+    if (opt.prefault) cflat_set_flag(flags, CFLAT_ARENA_PREFAULT);
+    if (opt.fixed_size) cflat_set_flag(flags, CFLAT_ARENA_FIXED_SIZE);
     cflat__os_commit(node, commit_size);
-    cflat_assert(node && "Bad alloc!");
-    cflat__node_init(node, CFLAT_ARENA_OWNS_MEMORY, reserve_size, commit_size);
+    if (opt.prefault) cflat__os_prefault(node, commit_size, page_size);
+    cflat__node_init(node, flags, reserve_size, commit_size, page_size);
     ASAN_POISON_MEMORY_REGION(node, commit_size);
     ASAN_UNPOISON_MEMORY_REGION(node, sizeof(*node));
-    return &node->_arena;
+    return node;
+}
+
+CflatArena* cflat_arena_new_opt(CflatArenaNewOpt opt) {
+    opt.reserve = cflat_max(opt.reserve, sizeof(CflatArena));
+    opt.commit  = cflat_max(opt.commit, sizeof(CflatArena));
+    CflatArena *arena = cflat__node_hold_arena(cflat__arena_node_new(opt));
+    arena->keep_warm  = opt.keep_warm;
+    arena->hysteresis = opt.hysteresis;
+    arena->growth     = opt.growth;
+    if (opt.growth_cap) arena->growth_cap = opt.growth_cap;
+    if (opt.commit_chunk) arena->commit_chunk = opt.commit_chunk;
+    if (opt.commit_cap) arena->commit_cap = opt.commit_cap;
+    arena->large_threshold = opt.large_threshold;
+    cflat_assert(arena->commit_chunk <= arena->commit_cap);
+    CFLAT__ARENA_STAT(arena->stats.commit_calls = 1);
+    cflat__arena_track(arena);
+    return arena;
+}
+
+static usize cflat__arena_free_bucket(usize size) {
+    const usize log = (usize)cflat_log2_u64(size | 1);
+    if (log < CFLAT__ARENA_FREE_BUCKET_SHIFT) return 0;
+    const usize split = (size >> (log - CFLAT__ARENA_FREE_BUCKET_SPLIT)) & ((1 << CFLAT__ARENA_FREE_BUCKET_SPLIT) - 1);
+    const usize bucket = ((log - CFLAT__ARENA_FREE_BUCKET_SHIFT) << CFLAT__ARENA_FREE_BUCKET_SPLIT) | split;
+    return cflat_min(bucket, CFLAT_ARENA_FREE_BUCKETS - 1);
+}
+
+// Room of the node for a request as it is asked for in a new node, the node holding the arena has less of it
+static inline usize cflat__node_room(const CflatArena *arena, const CflatArenaNode *node) {
+    return node->res - (cflat__node_begin(arena, node) - sizeof(CflatArenaNode));
+}
+
+static void cflat__arena_free_push(CflatArena *arena, CflatArenaNode *node) {
+    const usize bucket = cflat__arena_free_bucket(cflat__node_room(arena, node));
+    cflat_ll_push(arena->free[bucket], node, prev);
+    cflat_set_flag(arena->free_mask, 1ull << bucket);
+}
+
+// Best fit down to the granularity of a bucket, NULL if no free node can hold size bytes
+static CflatArenaNode* cflat__arena_free_take(CflatArena *arena, usize size) {
+    usize bucket = cflat__arena_free_bucket(size);
+    CflatArenaNode **link = &arena->free[bucket];
+
+    // Only the bucket size falls in can hold nodes that are too small, any node that fits is as good as the rest.
+    // The walk is bounded while a larger bucket can serve the request without looking at its nodes
+    const u64 larger = arena->free_mask & ~((2ull << bucket) - 1);
+    for (usize seen = 0; *link && cflat__node_room(arena, *link) < size; ++seen) {
+        if (larger && seen == CFLAT__ARENA_FREE_SCAN) break;
+        link = &(*link)->prev;
+    }
+
+    if (*link == NULL || cflat__node_room(arena, *link) < size) {
+        if (larger == 0) return NULL;
+        bucket = (usize)cflat_log2_u64(larger & (~larger + 1));
+        link = &arena->free[bucket];
+    }
+
+    CflatArenaNode *node = *link;
+    *link = node->prev;
+    if (arena->free[bucket] == NULL) cflat_clear_flag(arena->free_mask, 1ull << bucket);
+    node->pos = cflat__node_begin(arena, node);
+    return node;
+}
+
+static void cflat__arena_node_release(CflatArenaNode *node) {
+    const usize res = node->res;
+    if (cflat_has_flag(node->flags, CFLAT_ARENA_OWNS_MEMORY)) {
+        ASAN_UNPOISON_MEMORY_REGION(node, res);
+        cflat__os_release(node, res);
+        VALGRIND_FREELIKE_BLOCK(node, 0);
+    }
+    else if (cflat_has_flag(node->flags, CFLAT_ARENA_SHARED)) {
+        ASAN_UNPOISON_MEMORY_REGION(node, res);
+        cflat__os_shared_close(node, res);
+    }
+}
+
+// Remembers that [begin, end) of a memory mapped arena changed, in page granularity
+static void cflat__arena_file_mark(CflatArena *arena, usize begin, usize end) {
+    CflatArenaFile *file = arena->file;
+    const usize page_size = arena->page_size;
+    begin = begin & ~(page_size - 1);
+    end   = cflat_min(cflat_align_pow2(end, page_size), file->size);
+    if (begin >= end) return;
+
+    // Pushes mostly land right after the previous one, which is the last range
+    usize closest = 0, closest_gap = SIZE_MAX;
+    for (usize i = file->unflushed_count; i-- > 0;) {
+        const usize range_begin = file->unflushed[i].begin, range_end = file->unflushed[i].end;
+        const usize gap = end < range_begin ? range_begin - end : begin > range_end ? begin - range_end : 0;
+        if (gap == 0) {
+            file->unflushed[i].begin = cflat_min(range_begin, begin);
+            file->unflushed[i].end   = cflat_max(range_end, end);
+            return;
+        }
+        if (gap < closest_gap) closest = i, closest_gap = gap;
+    }
+
+    if (file->unflushed_count < CFLAT_ARENA_UNFLUSHED_RANGES) {
+        file->unflushed[file->unflushed_count].begin = begin;
+        file->unflushed[file->unflushed_count].end   = end;
+        file->unflushed_count += 1;
+        return;
+    }
+
+    // Out of ranges, the one closest to the new range swallows it and the pages between them
+    file->unflushed[closest].begin = cflat_min(file->unflushed[closest].begin, begin);
+    file->unflushed[closest].end   = cflat_max(file->unflushed[closest].end, end);
 }
 
+// Grows the file behind a memory mapped arena so its node can hold size bytes
+static bool cflat__arena_file_grow(CflatArena *arena, usize size) {
+    CflatArenaFile *file = arena->file;
+    CflatArenaNode *node = arena->curr;
+    const usize new_size = cflat_min(cflat_align_pow2(cflat_max(size, file->size * 2), arena->page_size), file->reserve);
+    if (new_size < size || !cflat__os_file_grow(file, (byte*)node, new_size)) return false;
+    node->res = node->cmt = new_size;
+    arena->reserve_size = arena->commit_size = new_size;
+    return true;
+}
+
+static void cflat__arena_large_release_from(CflatArena *arena, usize pos);
+
 void cflat_arena_delete(CflatArena *arena) {
     if (arena == NULL) return;
     cflat_assert(arena->curr != NULL);
-    CflatArenaNode *current = arena->curr;
-    CflatArenaNode *node = arena->free;
+    cflat__arena_untrack(arena);
+    cflat__arena_large_release_from(arena, 0);
+
+    if (arena->file) {
+        // The whole arena is the one node in the mapping
+        cflat_assert(arena->curr->prev == NULL);
+        CflatArenaFile *file = arena->file;
+        cflat_arena_flush(arena);
+        arena->file = NULL;
+        cflat__os_file_close(file, (byte*)arena);
+        free(file);
+        return;
+    }
+
+
+    CflatArenaNode *buckets[CFLAT_ARENA_FREE_BUCKETS];
+    cflat_mem_copy(buckets, arena->free, sizeof(buckets));
     CflatArenaNode *it;
 
-    for (it = current; it;) {
+    for (it = arena->curr; it;) {
         CflatArenaNode *prev = it->prev;
-        if (cflat_has_flag(it->_arena.flags, CFLAT_ARENA_OWNS_MEMORY)) {
-            const usize res = it->res;
-            ASAN_UNPOISON_MEMORY_REGION(it, res);
-            cflat__os_release(it, res);
-            VALGRIND_FREELIKE_BLOCK(it, 0);
-        } else if (cflat_has_flag(it->_arena.flags, CFLAT_MEMORY_MAPPED)) {
-            const usize res = it->res;
-            ASAN_UNPOISON_MEMORY_REGION(it, res);
-            cflat__os_flush_mapped_file(it, res);
-            cflat__os_unmap_file(it, res);
-            VALGRIND_FREELIKE_BLOCK(it, 0);
-        }
+        cflat__arena_node_release(it);
         it = prev;
     }
 
-    for (it = node; it;) {
-        CflatArenaNode *prev = it->prev;
-        if (cflat_has_flag(it->_arena.flags, CFLAT_ARENA_OWNS_MEMORY)) {
-            const usize res = it->res;
-            ASAN_UNPOISON_MEMORY_REGION(it, res);
-            cflat__os_release(it, res);
-            VALGRIND_FREELIKE_BLOCK(it, 0);
-        } else if (cflat_has_flag(it->_arena.flags, CFLAT_MEMORY_MAPPED)) {
-            const usize res = it->res;
-            ASAN_UNPOISON_MEMORY_REGION(it, res);
-            cflat__os_unmap_file(it, res);
-            VALGRIND_FREELIKE_BLOCK(it, 0);
+    for (usize bucket = 0; bucket < CFLAT_ARENA_FREE_BUCKETS; ++bucket) {
+        for (it = buckets[bucket]; it;) {
+            CflatArenaNode *prev = it->prev;
+            cflat__arena_node_release(it);
+            it = prev;
         }
-        it = prev;
     }
 
     //cflat_mem_zero(arena, sizeof (*arena));
 }
 
-void* cflat_arena_push_opt(CflatArena *arena, const usize size, CflatAllocOpt opt) {
+// Pushes into the nodes, never taking the large allocation path
+static void* cflat__arena_push_node(CflatArena *arena, const usize size, CflatAllocOpt opt) {
 
     if (arena == NULL) return NULL;
     cflat_assert(arena->curr != NULL);
@@ -475,29 +1197,38 @@ void* cflat_arena_push_opt(CflatArena *arena, const usize size, CflatAllocOpt op
     uptr pre = cflat_align_pow2(current_node->pos, opt.align);
     uptr pst = pre + size;
 
-    if (current_node->res < pst && !cflat_has_flag(arena->flags, CFLAT_ARENA_FIXED_SIZE)) {
-        CflatArenaNode *new_node = arena->free;
-
-        for(CflatArenaNode *prev_node = NULL; new_node; prev_node = new_node, new_node = new_node->prev) {
-            new_node->pos = sizeof(CflatArenaNode);
+    if (current_node->res < pst && arena->file) {
+        // A memory mapped arena only grows its file, a node outside of it wouldn't be persisted
+        if (!cflat__arena_file_grow(arena, pst)) return NULL;
+    }
 
-            if (new_node->res >= cflat_align_pow2(new_node->pos, opt.align) + size) {
-                if(prev_node) prev_node->prev = new_node->prev;
-                else arena->free = new_node->prev;
-                break;
-            }
+    if (current_node->res < pst && !cflat_has_flag(arena->flags, CFLAT_ARENA_FIXED_SIZE)) {
+        const usize needed = cflat_align_pow2(sizeof(CflatArenaNode), opt.align) + size;
+        CflatArenaNode *new_node = cflat__arena_free_take(arena, needed);
+        if (new_node && cflat_align_pow2(new_node->pos, opt.align) + size > new_node->res) {
+            // The node holding the arena can come up short once a big alignment is applied past the arena
+            cflat__arena_free_push(arena, new_node);
+            new_node = NULL;
         }
 
         if (new_node == NULL)
         {
-            usize res = current_node->res;
-            usize cmt = current_node->cmt;
-            if(size + sizeof(CflatArenaNode) > res)
-            {
-                res = cflat_align_pow2(size + sizeof(CflatArenaNode), opt.align);
-                cmt = cflat_align_pow2(size + sizeof(CflatArenaNode), opt.align);
+            usize res = needed;
+            switch (arena->growth) {
+            case CFLAT_ARENA_GROW_DOUBLE: res = cflat_min(current_node->res * 2, arena->growth_cap); break;
+            case CFLAT_ARENA_GROW_FIXED:  res = arena->reserve_size;                                 break;
+            case CFLAT_ARENA_GROW_EXACT:  res = needed;                                              break;
             }
-            new_node = cflat_arena_new(.reserve = res, .commit = cmt)->curr;
+            res = cflat_max(res, needed);
+            const usize cmt = cflat_min(arena->commit_size, res);
+            new_node = cflat__arena_node_new((CflatArenaNewOpt){
+                .reserve   = res,
+                .commit    = cmt,
+                .page_size = arena->page_size,
+                .prefault  = cflat_has_flag(arena->flags, CFLAT_ARENA_PREFAULT),
+            });
+            arena->committed += new_node->cmt;
+            CFLAT__ARENA_STAT(arena->stats.commit_calls += 1);
         }
 
         cflat_ll_push(arena->curr, new_node, prev);
@@ -506,37 +1237,126 @@ void* cflat_arena_push_opt(CflatArena *arena, const usize size, CflatAllocOpt op
         pst = pre + size;
     }
 
-    if(current_node->cmt < pst) {
-        usize commit_aligned_to_pst = pst + current_node->cmt - 1;
-        commit_aligned_to_pst -= commit_aligned_to_pst%current_node->cmt;
+    if(current_node->cmt < pst && current_node->cmt < current_node->res) {
+        // Steps double with what the node holds so filling it takes a logarithmic number of commits
+        const usize step = cflat_min(cflat_max(current_node->cmt, arena->commit_chunk), arena->commit_cap);
+        const usize commit_target = cflat_align_pow2(cflat_max(pst, current_node->cmt + step), current_node->page_size);
 
-        const usize commit_pst_clamped = cflat_min(commit_aligned_to_pst, current_node->res);
+        const usize commit_pst_clamped = cflat_min(commit_target, current_node->res);
         const usize cmt_size = commit_pst_clamped - current_node->cmt;
 
         byte *commited_ptr = (byte *)current_node + current_node->cmt;
         cflat__os_commit(commited_ptr, cmt_size);
+        if (cflat_has_flag(arena->flags, CFLAT_ARENA_PREFAULT)) cflat__os_prefault(commited_ptr, cmt_size, current_node->page_size);
         current_node->cmt = commit_pst_clamped;
+        arena->committed += cmt_size;
+        CFLAT__ARENA_STAT(arena->stats.commit_calls += 1);
     }
 
     void *result = NULL;
 
     if (current_node->cmt >= pst) {
         result = (byte *)current_node + pre;
+        CFLAT__ARENA_STAT(arena->stats.requested += size);
+        CFLAT__ARENA_STAT(arena->stats.consumed  += pst - current_node->pos);
         current_node->pos = pst;
         ASAN_UNPOISON_MEMORY_REGION(result, size);
-        if (opt.clear) cflat_mem_zero(result, size);
+        if (opt.clear && pre < current_node->dirty) cflat_mem_zero(result, cflat_min(pst, current_node->dirty) - pre);
+        current_node->dirty = cflat_max(current_node->dirty, pst);
+        if (arena->file) cflat__arena_file_mark(arena, pre, pst);
         arena->pos = cflat_align_pow2(arena->pos, opt.align) + size;
+        CFLAT__ARENA_STAT(arena->stats.peak_pos = cflat_max(arena->stats.peak_pos, arena->pos));
     }
 
     return result;
 }
 
+static CflatArenaLarge* cflat__arena_large_find(CflatArena *arena, void *ptr) {
+    for (CflatArenaLarge *large = arena->large; large; large = large->prev) {
+        if (large->data == ptr && large->size) return large;
+    }
+    return NULL;
+}
+
+static void* cflat__arena_push_large(CflatArena *arena, usize size, CflatAllocOpt opt) {
+    (void)opt; // Fresh mappings are zeroed and page aligned
+    const usize pos = arena->pos;
+    CflatArenaLarge *large = cflat__arena_push_node(arena, sizeof(*large), (CflatAllocOpt){ .align = cflat_alignof(CflatArenaLarge) });
+    if (large == NULL) return NULL;
+
+    const usize map_size = cflat_align_pow2(size, cflat__os_page_size());
+    byte *data = cflat__os_map(map_size);
+    if (data == NULL) {
+        cflat_arena_pop(arena, arena->pos - pos);
+        return NULL;
+    }
+    VALGRIND_MALLOCLIKE_BLOCK(data, map_size, 0, true);
+
+    *large = (CflatArenaLarge) { .prev = arena->large, .data = data, .size = map_size, .pos = pos };
+    arena->large = large;
+    CFLAT__ARENA_STAT(arena->stats.requested += size);
+    CFLAT__ARENA_STAT(arena->stats.consumed  += map_size);
+    return data;
+}
+
+static void cflat__arena_large_unmap(CflatArenaLarge *large) {
+    if (large->size == 0) return;
+    cflat__os_release(large->data, large->size);
+    VALGRIND_FREELIKE_BLOCK(large->data, 0);
+    large->size = 0;
+}
+
+// Unmaps every large allocation whose record sits at or above pos, before the records themselves are popped
+static void cflat__arena_large_release_from(CflatArena *arena, usize pos) {
+    while (arena->large && arena->large->pos >= pos) {
+        cflat__arena_large_unmap(arena->large);
+        arena->large = arena->large->prev;
+    }
+}
+
+static void* cflat__arena_large_resize(CflatArena *arena, CflatArenaLarge *large, usize newsize) {
+    (void)arena; // Only used by the stats
+    const usize map_size = cflat_align_pow2(cflat_max(newsize, 1), cflat__os_page_size());
+    if (map_size == large->size) return large->data;
+
+    byte *data = cflat__os_remap(large->data, large->size, map_size);
+    if (data) {
+        CFLAT__ARENA_STAT(arena->stats.extend_in_place += 1);
+    } else {
+        data = cflat__os_map(map_size);
+        if (data == NULL) return NULL;
+        cflat_mem_copy(data, large->data, cflat_min(large->size, map_size));
+        cflat__os_release(large->data, large->size);
+        CFLAT__ARENA_STAT(arena->stats.extend_copies += 1);
+    }
+    VALGRIND_FREELIKE_BLOCK(large->data, 0);
+    VALGRIND_MALLOCLIKE_BLOCK(data, map_size, 0, true);
+    large->data = data;
+    large->size = map_size;
+    return data;
+}
+
+void* cflat_arena_push_opt(CflatArena *arena, const usize size, CflatAllocOpt opt) {
+    if (arena == NULL) return NULL;
+    if (arena->large_threshold && size >= arena->large_threshold && opt.align <= cflat__os_page_size()) {
+        return cflat__arena_push_large(arena, size, opt);
+    }
+    return cflat__arena_push_node(arena, size, opt);
+}
+
+bool cflat_arena_release_large(CflatArena *arena, void *ptr) {
+    CflatArenaLarge *large = cflat__arena_large_find(arena, ptr);
+    if (large == NULL) return false;
+    cflat__arena_large_unmap(large);
+    return true;
+}
+
 bool cflat_arena_try_push_opt(CflatArena *arena, usize size, void **mem, CflatAllocOpt opt) {
     if (arena == NULL) return false;
     cflat_assert(arena->curr != NULL);
     cflat_assert(arena->curr->pos <= arena->curr->res);
     if ((arena->curr->res - arena->curr->pos) >= size) {
-        void* result = cflat_arena_push_opt(arena, size, opt);
+        void* result = cflat__arena_push_node(arena, size, opt);
         if (mem) *mem = result;
         return true;
     }
@@ -548,6 +1368,9 @@ void* cflat_arena_extend_opt(CflatArena *arena, void *ptr, usize oldsize, usize
     if (ptr == NULL) return cflat_arena_push_opt(arena, newsize, opt);
     if (oldsize == newsize) return ptr;
 
+    CflatArenaLarge *large = arena->large ? cflat__arena_large_find(arena, ptr) : NULL;
+    if (large) return cflat__arena_large_resize(arena, large, newsize);
+
     if (newsize < oldsize) {
         cflat_arena_pop(arena, oldsize - newsize);
         return ptr;
@@ -555,43 +1378,99 @@ void* cflat_arena_extend_opt(CflatArena *arena, void *ptr, usize oldsize, usize
 
     if ((uptr)cflat_arena_top(arena) == ((uptr)ptr + oldsize)) {
         if (cflat_arena_try_push_opt(arena, (newsize - oldsize), NULL, (CflatAllocOpt){.align=1,opt.clear})) {
+            CFLAT__ARENA_STAT(arena->stats.extend_in_place += 1);
             return ptr;
         }
     }
 
+    CFLAT__ARENA_STAT(arena->stats.extend_copies += 1);
     void *result = cflat_arena_push_opt(arena, newsize, opt);
     return cflat_mem_copy(result, ptr, oldsize);
 }
 
+// Returns committed memory above keep_warm to the os once it exceeds keep_warm + hysteresis
+// Free nodes are released first, then the unused tails of the live nodes are decommitted
+static void cflat__arena_trim_to(CflatArena *arena, usize keep_warm, usize hysteresis) {
+    if (keep_warm == 0) return;
+    if (arena->committed <= keep_warm + hysteresis) return;
+
+    const CflatArenaNode *owner = cflat__arena_owner(arena);
+    for (usize bucket = CFLAT_ARENA_FREE_BUCKETS; bucket-- > 0 && arena->committed > keep_warm;) {
+        CflatArenaNode **link = &arena->free[bucket];
+        while (*link && arena->committed > keep_warm) {
+            CflatArenaNode *node = *link;
+            if (node == owner || !cflat_has_flag(node->flags, CFLAT_ARENA_OWNS_MEMORY)) {
+                link = &node->prev;
+                continue;
+            }
+            *link = node->prev;
+            arena->committed -= node->cmt;
+            cflat__arena_node_release(node);
+            CFLAT__ARENA_STAT(arena->stats.decommit_calls += 1);
+        }
+        if (arena->free[bucket] == NULL) cflat_clear_flag(arena->free_mask, 1ull << bucket);
+    }
+
+    for (usize i = 0; i <= CFLAT_ARENA_FREE_BUCKETS; ++i) {
+        const bool is_free = i < CFLAT_ARENA_FREE_BUCKETS;
+        for (CflatArenaNode *node = is_free ? arena->free[i] : arena->curr; node && arena->committed > keep_warm; node = node->prev) {
+            if (!cflat_has_flag(node->flags, CFLAT_ARENA_OWNS_MEMORY)) continue;
+            const usize page_size = node->page_size;
+            const usize pos = is_free ? cflat__node_begin(arena, node) : node->pos;
+            const usize used = cflat_align_pow2(pos, page_size);
+            const usize excess = (arena->committed - keep_warm) & ~(page_size - 1);
+            if (node->cmt <= used || excess == 0) continue;
+            const usize size = cflat_min(node->cmt - used, excess);
+            node->cmt -= size;
+            arena->committed -= size;
+            if (cflat_has_flag(node->flags, CFLAT_ARENA_RESTORED)) cflat__os_decommit_image((byte*)node + node->cmt, size);
+            else                                                   cflat__os_decommit((byte*)node + node->cmt, size);
+            CFLAT__ARENA_STAT(arena->stats.decommit_calls += 1);
+            node->dirty = cflat_min(node->dirty, node->cmt);
+        }
+    }
+}
+
+static void cflat__arena_trim(CflatArena *arena) {
+    cflat__arena_trim_to(arena, arena->keep_warm, arena->hysteresis);
+}
+
+void cflat_arena_trim(CflatArena *arena, usize keep) {
+    // keep_warm of 0 means keep everything, a byte still lets every unused page go
+    cflat__arena_trim_to(arena, cflat_max(keep, 1), 0);
+}
+
 void cflat_arena_pop(CflatArena *arena, usize size) {
     if (size == 0) return;
     arena->pos = (arena->pos >= size) ? (arena->pos - size) : (0);
+    cflat__arena_large_release_from(arena, arena->pos);
 
     CflatArenaNode *curr = arena->curr;
     while (curr) {
         CflatArenaNode *prev = curr->prev;
-        const usize allocated = curr->pos - sizeof(*curr);
+        const usize begin = cflat__node_begin(arena, curr);
+        const usize allocated = curr->pos - begin;
         if (size < allocated) {
             const usize new_pos = curr->pos - size;
-            ASAN_POISON_MEMORY_REGION(curr->data + new_pos, curr->pos - new_pos);
+            ASAN_POISON_MEMORY_REGION((byte*)curr + new_pos, curr->pos - new_pos);
             curr->pos = new_pos;
             break;
         }
         size      -= allocated;
         curr->pos -= allocated;
-        ASAN_POISON_MEMORY_REGION(curr->data, curr->res - sizeof(*curr));
-        cflat_ll_push(arena->free, curr, prev);
+        ASAN_POISON_MEMORY_REGION((byte*)curr + begin, curr->res - begin);
         arena->curr = prev;
+        cflat__arena_free_push(arena, curr);
         curr = prev;
     }
 
     if (arena->curr == NULL) {
-        curr = arena->free;
-        curr->pos = sizeof(*curr);
-        arena->free = curr->prev;
-        cflat_ll_push(arena->curr, curr, prev);
+        curr = cflat__arena_free_take(arena, sizeof(*curr));
+        curr->prev = NULL;
         arena->curr = curr;
     }
+
+    cflat__arena_trim(arena);
 }
 
 void cflat_arena_set_pos(CflatArena *arena, const usize pos) {
@@ -599,30 +1478,30 @@ void cflat_arena_set_pos(CflatArena *arena, const usize pos) {
         cflat_arena_pop(arena, arena->pos - pos);
         return;
     }
-    cflat_arena_push(arena, pos, .align=1, .clear=false);
+    cflat__arena_push_node(arena, pos - arena->pos, (CflatAllocOpt){ .align = 1 });
 }
 
 void cflat_arena_clear(CflatArena *arena) {
 
     #if defined(ASAN_ENABLED)
     for (const CflatArenaNode *curr = arena->curr; curr; curr = curr->prev) {
-        ASAN_POISON_MEMORY_REGION(curr->data, curr->res - sizeof(*curr));
+        const usize begin = cflat__node_begin(arena, curr);
+        ASAN_POISON_MEMORY_REGION((byte*)curr + begin, curr->res - begin);
     }
     #endif
 
+    cflat__arena_large_release_from(arena, 0);
     arena->pos = 0;
-    CflatArenaNode *freelst = arena->free;
-    arena->free = arena->curr;
-    if (freelst) {
-        freelst->prev = arena->free;
-        arena->free = freelst;
+    CflatArenaNode *curr = arena->curr;
+    for (CflatArenaNode *it = curr->prev; it;) {
+        CflatArenaNode *prev = it->prev;
+        cflat__arena_free_push(arena, it);
+        it = prev;
     }
-    arena->curr = NULL;
-    freelst = arena->free;
-    freelst->pos = sizeof(*freelst);
-    arena->free = freelst->prev;
-    cflat_ll_push(arena->curr, freelst, prev);
-    arena->curr = freelst;
+    curr->prev = NULL;
+    curr->pos = cflat__node_begin(arena, curr);
+
+    cflat__arena_trim(arena);
 }
 
 CflatTempArena cflat_arena_temp_begin(CflatArena *arena) {
@@ -636,8 +1515,51 @@ void cflat_arena_temp_end(const CflatTempArena temp_arena) {
     cflat_arena_set_pos(temp_arena.arena, temp_arena.pos);
 }
 
-cflat_thread_local static CflatArena *cflat__tls_scratches[2] = {0};
-cflat_thread_local static byte cflat__tls_arena_bytes[CFLAT_ARRAY_SIZE(cflat__tls_scratches)][KiB(64)];
+cflat_thread_local static CflatArena *cflat__tls_scratches[CFLAT_SCRATCH_ARENA_COUNT] = {0};
+
+// Runs as the thread exits with its scratch array, the thread local storage is still there at that point
+static void cflat__scratch_arenas_thread_exit(void *scratches) {
+    CflatArena **arenas = scratches;
+    for (usize i = 0; i < CFLAT_SCRATCH_ARENA_COUNT; ++i) {
+        cflat_arena_delete(arenas[i]);
+        arenas[i] = NULL;
+    }
+}
+
+#if defined(OS_WINDOWS)
+static INIT_ONCE cflat__scratch_key_once = INIT_ONCE_STATIC_INIT;
+static DWORD     cflat__scratch_key      = FLS_OUT_OF_INDEXES;
+
+static void NTAPI cflat__scratch_key_destructor(void *scratches) {
+    if (scratches) cflat__scratch_arenas_thread_exit(scratches);
+}
+
+static BOOL CALLBACK cflat__scratch_key_create(PINIT_ONCE once, void *param, void **context) {
+    (void)once, (void)param, (void)context;
+    cflat__scratch_key = FlsAlloc(cflat__scratch_key_destructor);
+    return TRUE;
+}
+
+static void cflat__scratch_arenas_at_thread_exit(void) {
+    InitOnceExecuteOnce(&cflat__scratch_key_once, cflat__scratch_key_create, NULL, NULL);
+    if (cflat__scratch_key != FLS_OUT_OF_INDEXES) FlsSetValue(cflat__scratch_key, cflat__tls_scratches);
+}
+#elif defined(OS_UNIX)
+static pthread_once_t cflat__scratch_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  cflat__scratch_key;
+static bool           cflat__scratch_key_valid = false;
+
+static void cflat__scratch_key_create(void) {
+    cflat__scratch_key_valid = pthread_key_create(&cflat__scratch_key, cflat__scratch_arenas_thread_exit) == 0;
+}
+
+static void cflat__scratch_arenas_at_thread_exit(void) {
+    pthread_once(&cflat__scratch_key_once, cflat__scratch_key_create);
+    if (cflat__scratch_key_valid) pthread_setspecific(cflat__scratch_key, cflat__tls_scratches);
+}
+#else
+static void cflat__scratch_arenas_at_thread_exit(void) {}
+#endif
 
 CflatTempArena cflat_get_scratch_arena_opt(CflatScratchArenaScopeOpt opt) {
     usize conflicts_count = opt.conflicts_count;
@@ -652,7 +1574,7 @@ CflatTempArena cflat_get_scratch_arena_opt(CflatScratchArenaScopeOpt opt) {
 
         for(usize j = 0; j < conflicts_count; j += 1, conflict_ptr += 1)
         {
-            if(*arena_ptr == *conflict_ptr)
+            if(*arena_ptr != NULL && *arena_ptr == *conflict_ptr)
             {
                 has_conflict = true;
                 break;
@@ -663,8 +1585,10 @@ CflatTempArena cflat_get_scratch_arena_opt(CflatScratchArenaScopeOpt opt) {
         {
             result = *arena_ptr;
 
-            if (result == NULL || result->curr == NULL) {
-                result = cflat__tls_scratches[i] = cflat_arena_init(cflat__tls_arena_bytes[i], sizeof(cflat__tls_arena_bytes[i]));
+            if (result == NULL) {
+                // Only address space until something is pushed, threads that never use it pay nothing
+                result = cflat__tls_scratches[i] = cflat_arena_new(.reserve = CFLAT_SCRATCH_ARENA_RESERVE);
+                cflat__scratch_arenas_at_thread_exit();
             }
 
             break;
@@ -677,33 +1601,405 @@ CflatTempArena cflat_get_scratch_arena_opt(CflatScratchArenaScopeOpt opt) {
 
 void cflat_drop_scratch_arena(CflatTempArena temp_arena) {
     cflat_arena_temp_end(temp_arena);
+    // Trimmed only once idle so nested scopes don't commit and decommit the same pages over and over
+    if (temp_arena.arena->pos == 0) {
+        cflat__arena_trim_to(temp_arena.arena, CFLAT_SCRATCH_ARENA_KEEP_WARM, CFLAT_SCRATCH_ARENA_HYSTERESIS);
+    }
+}
+
+void cflat_release_scratch_arenas(void) {
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(cflat__tls_scratches); ++i) {
+        cflat_arena_delete(cflat__tls_scratches[i]);
+        cflat__tls_scratches[i] = NULL;
+    }
 }
 
 void* cflat_arena_top(CflatArena *arena) {
     return (void*)((uptr)arena->curr + arena->curr->pos);
 }
 
+usize cflat_arena_page_size(CflatArena *arena) {
+    return arena->page_size;
+}
+
+CflatArenaStats cflat_arena_stats(CflatArena *arena) {
+    CflatArenaStats stats = {0};
+    #if CFLAT_ARENA_STATS
+    stats = arena->stats;
+    #endif
+
+    for (CflatArenaNode *node = arena->curr; node; node = node->prev) {
+        stats.node_count += 1;
+        stats.reserved   += node->res;
+        stats.committed  += node->cmt;
+    }
+
+    cflat_arena_for_each_free_node(arena, node) {
+        stats.free_node_count += 1;
+        stats.reserved        += node->res;
+        stats.committed       += node->cmt;
+    }
+
+    for (CflatArenaLarge *large = arena->large; large; large = large->prev) {
+        if (large->size == 0) continue;
+        stats.large_count += 1;
+        stats.large_bytes += large->size;
+    }
+
+    return stats;
+}
+
+void cflat_arena_stats_dump(FILE *file) {
+    if (file == NULL) file = stderr;
+    #if CFLAT_ARENA_STATS
+    cflat__live_arenas_acquire();
+    for (CflatArena *arena = cflat__live_arenas; arena; arena = arena->live_next) {
+        const CflatArenaStats stats = cflat_arena_stats(arena);
+        fprintf(file,
+            "arena %p: requested %zu consumed %zu nodes %zu free %zu reserved %zu committed %zu "
+            "commits %zu decommits %zu peak %zu extend in place %zu copies %zu\n",
+            (void*)arena, stats.requested, stats.consumed, stats.node_count, stats.free_node_count,
+            stats.reserved, stats.committed, stats.commit_calls, stats.decommit_calls, stats.peak_pos,
+            stats.extend_in_place, stats.extend_copies);
+    }
+    cflat__live_arenas_release();
+    #else
+    fprintf(file, "arena stats are disabled, build with CFLAT_ARENA_STATS\n");
+    #endif
+}
+
+#define CFLAT_ARENA_FILE_MAGIC 0x414C4643u // "CFLA"
+
 CflatArena* cflat_arena_memory_mapped(const char *filepath, usize size_hint, CflatPermission permission) {
     cflat_assert(size_hint > 0);
 
-    const usize page_size = 4096;
-    size_hint = cflat_align_pow2(size_hint, page_size);
-    bool file_exists = cflat__os_file_exists(filepath);    
-    void *mem = cflat__os_memory_mapped_file(filepath, size_hint, permission);
-    if (mem == NULL) return NULL;
+    const usize page_size = cflat__os_page_size();
+    size_hint = cflat_align_pow2(cflat_max(size_hint, sizeof(CflatArena)), page_size);
 
-    CflatArenaNode *node = (CflatArenaNode*)mem;
+    CflatArenaFile *file = malloc(sizeof(*file));
+    if (file == NULL) return NULL;
+    *file = (CflatArenaFile) { .permission = permission, .reserve = CFLAT_ARENA_MAPPED_RESERVE };
+    byte *mem = cflat__os_file_open(file, filepath, size_hint);
+    if (mem == NULL) {
+        free(file);
+        return NULL;
+    }
 
-    if (!file_exists) {
-        cflat__node_init(mem, CFLAT_ARENA_FIXED_SIZE | CFLAT_MEMORY_MAPPED, size_hint, size_hint);
+    CflatArenaNode *node = (CflatArenaNode*)mem;
+    const CflatArenaFlags flags = CFLAT_MEMORY_MAPPED | (file->reserve > file->size ? 0 : CFLAT_ARENA_FIXED_SIZE);
+
+    CflatArena *arena = (CflatArena*)mem;
+    if (file->empty) {
+        cflat__node_init(node, flags, file->size, file->size, page_size);
+        cflat__node_hold_arena(node);
+        arena->file_magic = CFLAT_ARENA_FILE_MAGIC;
+        arena->file_header_size = sizeof(CflatArena);
+    }
+    else if (arena->file_magic != CFLAT_ARENA_FILE_MAGIC || arena->file_header_size != sizeof(CflatArena)) {
+        // Not an arena, or one whose fields sit at other offsets
+        cflat__os_file_close(file, mem);
+        free(file);
+        return NULL;
     }
     else {
-        node->_arena.curr = node;
-        if (node->_arena.pos > size_hint) node->_arena.pos = size_hint;
-        node->pos = node->_arena.pos;
+        // Everything in the header that points outside of the file is stale
+        cflat_mem_zero(arena->free, sizeof(arena->free));
+        arena->free_mask = 0;
+        arena->curr = node;
+        arena->flags = flags;
+        arena->page_size = page_size;
+        arena->large = NULL;
+        arena->large_threshold = 0;
+        arena->keep_warm = 0;
+        node->prev = NULL;
+        node->flags = flags;
+        node->page_size = page_size;
+        node->res = node->cmt = node->dirty = file->size;
+        node->pos = cflat_min(cflat_max(node->pos, sizeof(CflatArena)), node->res);
     }
     
-    CflatArena *arena = &((CflatArenaNode*)mem)->_arena;
+    arena->file = file;
+    arena->committed = arena->reserve_size = arena->commit_size = file->size;
+    #if CFLAT_ARENA_STATS
+    // Counters saved in the file are stale
+    arena->stats = (CflatArenaStats){0};
+    // Not tracked, the live arena links would be written to the file
+    arena->live_prev = arena->live_next = NULL;
+    #endif
+    return arena;
+}
+
+CflatArena* cflat_arena_shared(const char *name, usize size) {
+    const usize page_size = cflat__os_page_size();
+    size = cflat_align_pow2(cflat_max(size, sizeof(CflatArena)), page_size);
+
+    CflatArenaNode *node = (CflatArenaNode*)cflat__os_shared_open(name, size);
+    if (node == NULL) return NULL;
+    if (node->res == 0) {
+        cflat__node_init(node, CFLAT_ARENA_SHARED | CFLAT_ARENA_FIXED_SIZE, size, size, page_size);
+        cflat__node_hold_arena(node);
+    }
+    // Not tracked, the live arena links would sit in memory every process writes to
+    return (CflatArena*)node;
+}
+
+bool cflat_arena_shared_unlink(const char *name) {
+    #if defined(OS_UNIX)
+    return shm_unlink(name) == 0;
+    #else
+    // Windows drops the name along with the last handle
+    (void)name;
+    return true;
+    #endif
+}
+
+bool cflat_arena_flush(CflatArena *arena) {
+    CflatArenaFile *file = arena->file;
+    if (file == NULL || !file->shared) return true;
+
+    // The header holds the positions, without it a reopen wouldn't see the new data
+    cflat__arena_file_mark(arena, 0, sizeof(CflatArena));
+    bool result = true;
+    for (usize i = 0; i < file->unflushed_count; ++i) {
+        const usize begin = file->unflushed[i].begin, end = file->unflushed[i].end;
+        result &= cflat__os_flush_mapped_file((byte*)arena + begin, end - begin);
+    }
+    file->unflushed_count = 0;
+    return result;
+}
+
+void cflat_arena_mark_dirty(CflatArena *arena, const void *ptr, usize size) {
+    if (arena->file == NULL) return;
+    const usize begin = (usize)((const byte*)ptr - (const byte*)arena);
+    cflat__arena_file_mark(arena, begin, begin + size);
+}
+
+#define CFLAT__ARENA_SNAPSHOT_MAGIC 0x31504e5354414c43ull // "CLATSNP1"
+
+typedef struct cflat__arena_snapshot_header {
+    u64 magic;
+    u64 node_count;
+    u32 arena_size; // sizeof(CflatArena) of the build that wrote it, it moves with CFLAT_ARENA_STATS and the free buckets
+    u32 node_size;  // sizeof(CflatArenaNode)
+} CflatArenaSnapshotHeader;
+
+typedef struct cflat__arena_snapshot_node {
+    u64 address; // Where the node lived, restore maps it back there so raw pointers into it stay valid
+    u64 offset;  // Page aligned offset of the image in the file
+    u64 size;    // Bytes of the image, the used part of the node rounded up to a page
+    u64 res;
+    u64 free;    // Out of the curr chain, only the node holding the arena is kept when it is free
+    u64 owner;   // Holds the arena
+} CflatArenaSnapshotNode;
+
+#if defined(OS_UNIX)
+// writev that keeps going after partial writes
+static bool cflat__os_write_all(int fd, struct iovec *iov, usize count) {
+    while (count > 0) {
+        const int batch = (int)cflat_min(count, (usize)IOV_MAX);
+        isize written = writev(fd, iov, batch);
+        if (written < 0) return false;
+        while (count > 0 && (usize)written >= iov->iov_len) {
+            written -= (isize)iov->iov_len;
+            iov += 1;
+            count -= 1;
+        }
+        if (count > 0) {
+            iov->iov_base = (byte*)iov->iov_base + written;
+            iov->iov_len -= (usize)written;
+        }
+    }
+    return true;
+}
+#endif
+
+bool cflat_arena_snapshot(CflatArena *arena, const char *path) {
+    // Large allocations and mapped files live outside the nodes
+    if (arena->large || arena->file) return false;
+
+    CflatArenaNode *owner = cflat__arena_owner(arena);
+    const usize page_size = cflat__os_page_size();
+    bool owner_in_chain = false;
+    usize node_count = 0;
+    for (CflatArenaNode *node = arena->curr; node; node = node->prev) {
+        owner_in_chain |= node == owner;
+        node_count += 1;
+    }
+    node_count += !owner_in_chain;
+
+    const usize header_size = cflat_align_pow2(sizeof(CflatArenaSnapshotHeader) + node_count * sizeof(CflatArenaSnapshotNode), page_size);
+    byte *header = calloc(1, header_size);
+    if (header == NULL) return false;
+    *(CflatArenaSnapshotHeader*)header = (CflatArenaSnapshotHeader) {
+        .magic      = CFLAT__ARENA_SNAPSHOT_MAGIC,
+        .node_count = node_count,
+        .arena_size = sizeof(CflatArena),
+        .node_size  = sizeof(CflatArenaNode),
+    };
+    CflatArenaSnapshotNode *entries = (CflatArenaSnapshotNode*)(header + sizeof(CflatArenaSnapshotHeader));
+
+    usize offset = header_size, i = 0;
+    for (CflatArenaNode *node = arena->curr; node || !owner_in_chain; node = node ? node->prev : NULL) {
+        const bool free = node == NULL;
+        if (free) node = owner, owner_in_chain = true;
+        const usize size = cflat_align_pow2(free ? sizeof(CflatArena) : node->pos, page_size);
+        entries[i++] = (CflatArenaSnapshotNode) {
+            .address = (uptr)node,
+            .offset  = offset,
+            .size    = size,
+            .res     = node->res,
+            .free    = free,
+            .owner   = node == owner,
+        };
+        offset += size;
+        if (free) break;
+    }
+
+    bool result = false;
+    #if defined(OS_UNIX)
+    struct iovec *iov = malloc((node_count + 1) * sizeof(*iov));
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (iov && fd != -1) {
+        iov[0] = (struct iovec) { .iov_base = header, .iov_len = header_size };
+        for (i = 0; i < node_count; ++i) {
+            // The tail past pos may be poisoned, it is written as is
+            ASAN_UNPOISON_MEMORY_REGION((void*)(uptr)entries[i].address, entries[i].size);
+            iov[i + 1] = (struct iovec) { .iov_base = (void*)(uptr)entries[i].address, .iov_len = entries[i].size };
+        }
+        result = cflat__os_write_all(fd, iov, node_count + 1);
+        for (i = 0; i < node_count; ++i) {
+            CflatArenaNode *node = (CflatArenaNode*)(uptr)entries[i].address;
+            const usize used = entries[i].free ? sizeof(CflatArena) : node->pos;
+            ASAN_POISON_MEMORY_REGION((byte*)node + used, entries[i].size - used);
+        }
+    }
+    if (fd != -1) close(fd);
+    free(iov);
+    #elif defined(OS_WINDOWS)
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        DWORD written;
+        result = WriteFile(file, header, (DWORD)header_size, &written, NULL);
+        for (i = 0; result && i < node_count; ++i) {
+            result = WriteFile(file, (void*)(uptr)entries[i].address, (DWORD)entries[i].size, &written, NULL);
+        }
+        CloseHandle(file);
+    }
+    #else
+    #error Unsupported platform
+    #endif
+
+    free(header);
+    return result;
+}
+
+// Maps the image of a node back at its old address, with the rest of its reserve behind it
+static bool cflat__os_restore_node(const CflatArenaSnapshotNode *entry, const char *path, isize fd) {
+    void *address = (void*)(uptr)entry->address;
+    #if defined(OS_UNIX)
+    (void)path;
+    // Kernels without MAP_FIXED_NOREPLACE take the address as a hint, so where it landed is checked too
+    byte *reserved = mmap(address, entry->res, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+    if (reserved == MAP_FAILED) return false;
+    if (reserved != address) {
+        munmap(reserved, entry->res);
+        return false;
+    }
+    if (mmap(address, entry->size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, (int)fd, (off_t)entry->offset) == MAP_FAILED) {
+        munmap(reserved, entry->res);
+        return false;
+    }
+    return true;
+    #elif defined(OS_WINDOWS)
+    // No copy on write views inside a reservation, the image is read in instead
+    (void)fd;
+    if (VirtualAlloc(address, entry->res, MEM_RESERVE, PAGE_READWRITE) != address) return false;
+    VirtualAlloc(address, entry->size, MEM_COMMIT, PAGE_READWRITE);
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER offset = { .QuadPart = (LONGLONG)entry->offset };
+    DWORD read = 0;
+    const bool result = file != INVALID_HANDLE_VALUE && SetFilePointerEx(file, offset, NULL, FILE_BEGIN)
+        && ReadFile(file, address, (DWORD)entry->size, &read, NULL) && read == entry->size;
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    if (!result) VirtualFree(address, 0, MEM_RELEASE);
+    return result;
+    #else
+    #error Unsupported platform
+    #endif
+}
+
+CflatArena* cflat_arena_restore(const char *path) {
+    CflatArenaSnapshotHeader header = {0};
+    CflatArenaSnapshotNode *entries = NULL;
+    isize fd = -1;
+    usize restored = 0;
+    CflatArena *arena = NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    if (fseek(file, 0, SEEK_END) != 0) goto done;
+    const long file_end = ftell(file);
+    if (file_end < (long)sizeof(header) || fseek(file, 0, SEEK_SET) != 0) goto done;
+    const u64 file_size = (u64)file_end;
+
+    if (fread(&header, sizeof(header), 1, file) != 1) goto done;
+    if (header.magic != CFLAT__ARENA_SNAPSHOT_MAGIC || header.arena_size != sizeof(CflatArena) || header.node_size != sizeof(CflatArenaNode)) goto done;
+    // The entries have to fit in the file, which also keeps the allocation from overflowing
+    if (header.node_count == 0 || header.node_count > (file_size - sizeof(header)) / sizeof(*entries)) goto done;
+    entries = malloc(header.node_count * sizeof(*entries));
+    if (entries == NULL || fread(entries, sizeof(*entries), header.node_count, file) != header.node_count) goto done;
+
+    for (usize i = 0; i < header.node_count; ++i) {
+        const CflatArenaSnapshotNode *entry = &entries[i];
+        const u64 min_size = entry->owner ? sizeof(CflatArena) : sizeof(CflatArenaNode);
+        if (entry->size < min_size || entry->size > entry->res || entry->offset > file_size || entry->size > file_size - entry->offset) goto done;
+    }
+
+    #if defined(OS_UNIX)
+    fd = open(path, O_RDONLY);
+    if (fd == -1) goto done;
+    #endif
+
+    for (; restored < header.node_count; ++restored) {
+        if (!cflat__os_restore_node(&entries[restored], path, fd)) goto done;
+    }
+
+    for (usize i = 0; i < header.node_count; ++i) {
+        if (entries[i].owner) arena = (CflatArena*)(uptr)entries[i].address;
+    }
+    if (arena == NULL) goto done;
+    // The curr chain comes first in the file, its prev links are still right since every node is back where it was
+    arena->curr = (CflatArenaNode*)(uptr)entries[0].address;
+    cflat_mem_zero(arena->free, sizeof(arena->free));
+    arena->free_mask = 0;
+    arena->committed = 0;
+    for (usize i = 0; i < header.node_count; ++i) {
+        CflatArenaNode *node = (CflatArenaNode*)(uptr)entries[i].address;
+        // The bytes between pos and the end of the image are whatever was there, the tail is fresh
+        node->cmt = node->dirty = entries[i].size;
+        node->flags = (node->flags & ~(CflatArenaFlags)(CFLAT_ARENA_HUGE_PAGES | CFLAT_ARENA_TRANSPARENT_HUGE_PAGES)) | CFLAT_ARENA_OWNS_MEMORY | CFLAT_ARENA_RESTORED;
+        arena->committed += node->cmt;
+        if (entries[i].free) {
+            node->pos = cflat__node_begin(arena, node);
+            cflat__arena_free_push(arena, node);
+        }
+    }
+    // New nodes are mapped fresh
+    arena->flags = cflat__arena_owner(arena)->flags & ~(CflatArenaFlags)CFLAT_ARENA_RESTORED;
+    #if CFLAT_ARENA_STATS
+    arena->stats = (CflatArenaStats){0};
+    #endif
+    cflat__arena_track(arena);
+
+done:
+    if (arena == NULL) {
+        for (usize i = 0; i < restored; ++i) cflat__os_release((void*)(uptr)entries[i].address, entries[i].res);
+    }
+    #if defined(OS_UNIX)
+    if (fd != -1) close((int)fd);
+    #endif
+    free(entries);
+    fclose(file);
     return arena;
 }
 
@@ -713,6 +2009,16 @@ CflatArena* cflat_arena_memory_mapped(const char *filepath, usize size_hint, Cfl
 #ifndef CFLAT_ARENA_NO_ALIAS
 
 #   define arena_memory_mapped cflat_arena_memory_mapped
+#   define arena_flush cflat_arena_flush
+#   define arena_shared cflat_arena_shared
+#   define arena_shared_unlink cflat_arena_shared_unlink
+#   define arena_snapshot cflat_arena_snapshot
+#   define arena_restore cflat_arena_restore
+#   define RelPtr CflatRelPtr
+#   define rel_set cflat_rel_set
+#   define rel_get cflat_rel_get
+#   define rel_is_null cflat_rel_is_null
+#   define arena_mark_dirty cflat_arena_mark_dirty
 #   define Permission CflatPermission
 #   define ArenaFlags CflatArenaFlags
 #   define PERMISSION_READ CFLAT_PERMISSION_READ
@@ -726,13 +2032,22 @@ CflatArena* cflat_arena_memory_mapped(const char *filepath, usize size_hint, Cfl
 #   define arena_push cflat_arena_push
 #   define arena_extend cflat_arena_extend
 #   define arena_try_push cflat_arena_try_push
+#   define arena_release_large cflat_arena_release_large
+#   define ArenaLarge CflatArenaLarge
 #   define arena_pop cflat_arena_pop
 #   define arena_clear cflat_arena_clear
+#   define arena_trim cflat_arena_trim
 #   define arena_set_pos cflat_arena_set_pos
 #   define arena_delete cflat_arena_delete
 #   define arena_top cflat_arena_top
+#   define arena_page_size cflat_arena_page_size
+#   define arena_stats cflat_arena_stats
+#   define arena_stats_dump cflat_arena_stats_dump
+#   define ArenaStats CflatArenaStats
+#   define arena_for_each_free_node cflat_arena_for_each_free_node
 #   define get_scratch_arena cflat_get_scratch_arena
 #   define drop_scratch_arena cflat_drop_scratch_arena
+#   define release_scratch_arenas cflat_release_scratch_arenas
 #   define scratch_arena_scope cflat_scratch_arena_scope
 #   define arena_scratch_scope cflat_scratch_arena_scope // Discoverability is a hell of a drug
 #   define temp_arena_scope cflat_temp_arena_scope
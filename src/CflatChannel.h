@@ -0,0 +1,211 @@
+#ifndef CFLAT_CHANNEL_H
+#define CFLAT_CHANNEL_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+#include <stdatomic.h>
+
+/*
+ Single producer single consumer queue of payloads that live in an arena
+ A message carries the offset of its payload from the arena instead of the payload,
+ so a channel pushed in a cflat_arena_shared arena moves data between processes without copying it
+ The payload belongs to the consumer until it receives the next message or calls cflat_channel_release,
+ a producer reusing one payload buffer per slot (see cflat_channel_next_slot) never overwrites one being read
+*/
+typedef struct cflat_channel_message {
+    isize offset; // From the arena the channel was created in
+    usize size;
+} CflatChannelMessage;
+
+typedef struct cflat_channel {
+    cflat_alignas(CFLAT_CACHE_LINE_SIZE) _Atomic usize head; // Messages the consumer is done with
+    usize next;                                              // Next message to receive, only the consumer touches it
+    cflat_alignas(CFLAT_CACHE_LINE_SIZE) _Atomic usize tail; // Messages sent
+    cflat_alignas(CFLAT_CACHE_LINE_SIZE) usize capacity;
+    _Atomic bool closed;
+    CflatChannelMessage messages[];
+} CflatChannel;
+
+/*
+Pushes a channel in the arena, the peers find it through an offset or a CflatRelPtr like any other payload
+@param arena:    the arena, payloads must be pushed in it too
+@param capacity: messages that can be in flight, rounded up to a power of two
+*/
+CFLAT_DEF CflatChannel*       cflat_channel_new      (CflatArena *arena, usize capacity                        );
+
+/*
+Sends a message if there is room for it
+@param channel: the channel
+@param message: the message, see cflat_channel_message
+*/
+CFLAT_DEF bool                cflat_channel_try_send (CflatChannel *channel, CflatChannelMessage message       );
+
+/*
+Sends a message, waiting for room, false if the channel was closed
+@param channel: the channel
+@param message: the message, see cflat_channel_message
+*/
+CFLAT_DEF bool                cflat_channel_send     (CflatChannel *channel, CflatChannelMessage message       );
+
+/*
+Receives a message if there is one, handing the previous one back
+@param channel: the channel
+@param message: where the message is written
+*/
+CFLAT_DEF bool                cflat_channel_try_recv (CflatChannel *channel, CflatChannelMessage *message      );
+
+/*
+Receives a message, waiting for one, false once the channel is closed and empty
+@param channel: the channel
+@param message: where the message is written
+*/
+CFLAT_DEF bool                cflat_channel_recv     (CflatChannel *channel, CflatChannelMessage *message      );
+
+/*
+Hands the last received message back without waiting for the next one
+@param channel: the channel
+*/
+CFLAT_DEF void                cflat_channel_release  (CflatChannel *channel                                    );
+
+/*
+Waits for room to send and gives the slot the next message goes in, in [0, capacity), false if the channel was closed
+The payload of the message that last used the slot was handed back, its buffer can be overwritten
+@param channel: the channel
+@param slot:    where the slot is written
+*/
+CFLAT_DEF bool                cflat_channel_next_slot(CflatChannel *channel, usize *slot                       );
+
+/*
+Tells the consumer no more messages are coming, the ones in flight are still received
+A consumer that stops listening closes it too, so a producer waiting for room gives up
+@param channel: the channel
+*/
+CFLAT_DEF void                cflat_channel_close    (CflatChannel *channel                                    );
+
+/*
+Number of messages sent and not yet handed back
+@param channel: the channel
+*/
+CFLAT_DEF usize               cflat_channel_count    (CflatChannel *channel                                    );
+
+#define cflat_channel_message(ARENA, PAYLOAD, SIZE) ((CflatChannelMessage){ .offset = cflat__rel_offset((ARENA), (PAYLOAD)), .size = (SIZE) })
+#define cflat_channel_payload(ARENA, MESSAGE)       cflat__rel_resolve((ARENA), (MESSAGE).offset)
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_CHANNEL_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_CHANNEL_H
+
+#if defined(CFLAT_CHANNEL_IMPLEMENTATION)
+
+#if defined(OS_WINDOWS)
+#include <processthreadsapi.h>
+#elif defined(OS_UNIX)
+#include <sched.h>
+#endif
+
+// The peer may be another process on the same core, so after a short spin it gets the core
+static void cflat__channel_backoff(usize spins) {
+    if (spins < 64) {
+        cflat_pause();
+        return;
+    }
+    #if defined(OS_WINDOWS)
+    SwitchToThread();
+    #elif defined(OS_UNIX)
+    sched_yield();
+    #endif
+}
+
+CflatChannel* cflat_channel_new(CflatArena *arena, usize capacity) {
+    capacity = (usize)cflat_next_pow2((u64)cflat_max(capacity, 1));
+    CflatChannel *channel = cflat_arena_push(arena, sizeof(CflatChannel) + capacity * sizeof(CflatChannelMessage), .align = CFLAT_CACHE_LINE_SIZE);
+    if (channel == NULL) return NULL;
+    atomic_init(&channel->head, 0);
+    atomic_init(&channel->tail, 0);
+    atomic_init(&channel->closed, false);
+    channel->next = 0;
+    channel->capacity = capacity;
+    return channel;
+}
+
+bool cflat_channel_try_send(CflatChannel *channel, CflatChannelMessage message) {
+    const usize tail = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    const usize head = atomic_load_explicit(&channel->head, memory_order_acquire);
+    if (tail - head == channel->capacity) return false;
+    channel->messages[tail & (channel->capacity - 1)] = message;
+    atomic_store_explicit(&channel->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool cflat_channel_send(CflatChannel *channel, CflatChannelMessage message) {
+    for (usize spins = 0; !cflat_channel_try_send(channel, message); ++spins) {
+        if (atomic_load_explicit(&channel->closed, memory_order_relaxed)) return false;
+        cflat__channel_backoff(spins);
+    }
+    return true;
+}
+
+bool cflat_channel_try_recv(CflatChannel *channel, CflatChannelMessage *message) {
+    const usize next = channel->next;
+    atomic_store_explicit(&channel->head, next, memory_order_release);
+    if (next == atomic_load_explicit(&channel->tail, memory_order_acquire)) return false;
+    *message = channel->messages[next & (channel->capacity - 1)];
+    channel->next = next + 1;
+    return true;
+}
+
+bool cflat_channel_recv(CflatChannel *channel, CflatChannelMessage *message) {
+    for (usize spins = 0; !cflat_channel_try_recv(channel, message); ++spins) {
+        // Closing happens after the last send, one more look catches a message sent right before it
+        if (atomic_load_explicit(&channel->closed, memory_order_acquire)) return cflat_channel_try_recv(channel, message);
+        cflat__channel_backoff(spins);
+    }
+    return true;
+}
+
+void cflat_channel_release(CflatChannel *channel) {
+    atomic_store_explicit(&channel->head, channel->next, memory_order_release);
+}
+
+bool cflat_channel_next_slot(CflatChannel *channel, usize *slot) {
+    const usize tail = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    for (usize spins = 0; tail - atomic_load_explicit(&channel->head, memory_order_acquire) == channel->capacity; ++spins) {
+        if (atomic_load_explicit(&channel->closed, memory_order_relaxed)) return false;
+        cflat__channel_backoff(spins);
+    }
+    *slot = tail & (channel->capacity - 1);
+    return true;
+}
+
+void cflat_channel_close(CflatChannel *channel) {
+    atomic_store_explicit(&channel->closed, true, memory_order_release);
+}
+
+usize cflat_channel_count(CflatChannel *channel) {
+    const usize head = atomic_load_explicit(&channel->head, memory_order_acquire);
+    const usize tail = atomic_load_explicit(&channel->tail, memory_order_acquire);
+    return tail - head;
+}
+
+#endif // CFLAT_CHANNEL_IMPLEMENTATION
+#undef CFLAT_CHANNEL_IMPLEMENTATION
+
+#if !defined(CFLAT_CHANNEL_NO_ALIAS)
+
+#   define Channel CflatChannel
+#   define ChannelMessage CflatChannelMessage
+#   define channel_new cflat_channel_new
+#   define channel_try_send cflat_channel_try_send
+#   define channel_send cflat_channel_send
+#   define channel_try_recv cflat_channel_try_recv
+#   define channel_recv cflat_channel_recv
+#   define channel_release cflat_channel_release
+#   define channel_next_slot cflat_channel_next_slot
+#   define channel_close cflat_channel_close
+#   define channel_count cflat_channel_count
+#   define channel_message cflat_channel_message
+#   define channel_payload cflat_channel_payload
+
+#endif // CFLAT_CHANNEL_NO_ALIAS
@@ -0,0 +1,223 @@
+#ifndef CFLAT_CONCURRENT_ARENA_H
+#define CFLAT_CONCURRENT_ARENA_H
+
+#include <stdatomic.h>
+#include "CflatCore.h"
+#include "CflatBit.h"
+#include "CflatArena.h"
+
+/*
+ Bump allocator that can be pushed to from many threads at once
+ Allocation is a single atomic fetch-add on the current node, only the thread whose
+ request straddles the end of the node installs the next one, everyone else waits for it
+ Clearing and deleting are not thread safe, the arena must be quiescent
+*/
+typedef struct cflat_concurrent_arena {
+    _Atomic(struct cflat_concurrent_arena_node*) curr;
+    struct cflat_concurrent_arena_node *free;
+    usize reserve;
+} CflatConcurrentArena;
+
+typedef struct cflat_concurrent_arena_node {
+    CflatConcurrentArena _arena;
+    struct cflat_concurrent_arena_node *prev;
+    usize res;
+    _Atomic usize pos;
+    byte data[];
+} CflatConcurrentArenaNode;
+
+/*
+@param reserve: size of each node, nodes are committed in full when created
+*/
+typedef struct cflat_concurrent_arena_new_opt {
+    usize reserve;
+} CflatConcurrentArenaNewOpt;
+
+/*
+Allocates a new concurrent arena using os specific memory allocation
+@param opt: @inherit(CflatConcurrentArenaNewOpt)
+*/
+CFLAT_DEF CflatConcurrentArena* cflat_concurrent_arena_new_opt  (CflatConcurrentArenaNewOpt opt                              );
+
+/*
+Allocates size bytes of memory from the arena, safe to call from any number of threads
+@param arena: the arena
+@param size:  size in bytes to allocate
+@param opt:   @inherit(CflatAllocOpt)
+*/
+CFLAT_DEF void*                 cflat_concurrent_arena_push_opt (CflatConcurrentArena *arena, usize size, CflatAllocOpt opt );
+
+/*
+Clears the arena, making it possible to reuse the memory
+No other thread may be pushing to the arena while it is cleared
+@param arena: the arena
+*/
+CFLAT_DEF void                  cflat_concurrent_arena_clear    (CflatConcurrentArena *arena                                 );
+
+/*
+Destroys the arena releasing every node back to the os
+@param arena: the arena
+*/
+CFLAT_DEF void                  cflat_concurrent_arena_delete   (CflatConcurrentArena *arena                                 );
+
+#define CFLAT_DEFAULT_CONCURRENT_RESERVE_SIZE MiB(1)
+
+#define cflat_concurrent_arena_new(...)              CFLAT_OPT(cflat_concurrent_arena_new_opt((CflatConcurrentArenaNewOpt){ .reserve = CFLAT_DEFAULT_CONCURRENT_RESERVE_SIZE, __VA_ARGS__ }))
+#define cflat_concurrent_arena_push(a, size, ...)    CFLAT_OPT(cflat_concurrent_arena_push_opt((a), (size), (CflatAllocOpt){ .align = cflat_alignof(uptr), __VA_ARGS__}))
+#define cflat_concurrent_arena_push_array(T, ARENA, N, ...) CFLAT_OPT((T*)cflat_concurrent_arena_push((ARENA), sizeof(T) * (N), .align=cflat_alignof(T), __VA_ARGS__))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_CONCURRENT_ARENA_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_CONCURRENT_ARENA_H
+
+#if defined(CFLAT_CONCURRENT_ARENA_IMPLEMENTATION)
+
+#if defined(OS_WINDOWS)
+#include <processthreadsapi.h>
+#elif defined(OS_UNIX)
+#include <sched.h>
+#endif
+
+// Every request is rounded to this so the position stays aligned for the common case
+#define CFLAT__CONCURRENT_ARENA_GRAIN cflat_alignof(uptr)
+
+// Spin briefly, then give the overflowing thread a chance to run if it got descheduled
+static void cflat__concurrent_arena_backoff(usize spins) {
+    if (spins < 64) {
+        cflat_pause();
+        return;
+    }
+    #if defined(OS_WINDOWS)
+    SwitchToThread();
+    #elif defined(OS_UNIX)
+    sched_yield();
+    #endif
+}
+
+static CflatConcurrentArenaNode* cflat__concurrent_arena_node_new(usize res) {
+    res = cflat_align_pow2(res, cflat__os_page_size());
+    CflatConcurrentArenaNode *node = cflat__os_reserve(res);
+    cflat_assert(node && "Bad alloc!");
+    cflat__os_commit(node, res);
+    node->prev = NULL;
+    node->res  = res;
+    atomic_init(&node->pos, sizeof(CflatConcurrentArenaNode));
+    return node;
+}
+
+CflatConcurrentArena* cflat_concurrent_arena_new_opt(CflatConcurrentArenaNewOpt opt) {
+    if (opt.reserve == 0) opt.reserve = CFLAT_DEFAULT_CONCURRENT_RESERVE_SIZE;
+    CflatConcurrentArenaNode *node = cflat__concurrent_arena_node_new(opt.reserve);
+    CflatConcurrentArena *arena = &node->_arena;
+    atomic_init(&arena->curr, node);
+    arena->free    = NULL;
+    arena->reserve = node->res;
+    return arena;
+}
+
+static CflatConcurrentArenaNode* cflat__concurrent_arena_take_node(CflatConcurrentArena *arena, usize size) {
+    const usize needed = sizeof(CflatConcurrentArenaNode) + size;
+
+    for (CflatConcurrentArenaNode *prev_node = NULL, *node = arena->free; node; prev_node = node, node = node->prev) {
+        if (node->res >= needed) {
+            if (prev_node) prev_node->prev = node->prev;
+            else arena->free = node->prev;
+            atomic_store_explicit(&node->pos, sizeof(CflatConcurrentArenaNode), memory_order_relaxed);
+            return node;
+        }
+    }
+
+    return cflat__concurrent_arena_node_new(cflat_max(arena->reserve, needed));
+}
+
+void* cflat_concurrent_arena_push_opt(CflatConcurrentArena *arena, usize size, CflatAllocOpt opt) {
+
+    if (arena == NULL) return NULL;
+    if (opt.align == 0) opt.align = cflat_alignof(uptr);
+    const usize grain   = CFLAT__CONCURRENT_ARENA_GRAIN;
+    const usize padding = opt.align > grain ? opt.align - grain : 0;
+    const usize request = cflat_align_pow2(size, grain) + padding;
+
+    void *result = NULL;
+    while (result == NULL) {
+        CflatConcurrentArenaNode *node = atomic_load_explicit(&arena->curr, memory_order_acquire);
+        const usize pre = atomic_fetch_add_explicit(&node->pos, request, memory_order_relaxed);
+        const usize pst = pre + request;
+
+        if (pst <= node->res) {
+            result = (void*)cflat_align_pow2((uptr)node + pre, opt.align);
+            break;
+        }
+
+        if (pre <= node->res) {
+            // Exactly one request straddles the end of a node, that thread owns the overflow.
+            // The free list is only touched here and the release store below hands it to the next owner
+            CflatConcurrentArenaNode *new_node = cflat__concurrent_arena_take_node(arena, request);
+            const usize new_pre = atomic_load_explicit(&new_node->pos, memory_order_relaxed);
+            atomic_store_explicit(&new_node->pos, new_pre + request, memory_order_relaxed);
+            new_node->prev = node;
+            atomic_store_explicit(&arena->curr, new_node, memory_order_release);
+            result = (void*)cflat_align_pow2((uptr)new_node + new_pre, opt.align);
+            break;
+        }
+
+        for (usize spins = 0; atomic_load_explicit(&arena->curr, memory_order_acquire) == node; ++spins) {
+            cflat__concurrent_arena_backoff(spins);
+        }
+    }
+
+    if (opt.clear) cflat_mem_zero(result, size);
+    return result;
+}
+
+void cflat_concurrent_arena_clear(CflatConcurrentArena *arena) {
+    CflatConcurrentArenaNode *first = container_of(arena, CflatConcurrentArenaNode, _arena);
+    CflatConcurrentArenaNode *curr  = atomic_load_explicit(&arena->curr, memory_order_acquire);
+
+    while (curr != first) {
+        CflatConcurrentArenaNode *prev = curr->prev;
+        cflat_ll_push(arena->free, curr, prev);
+        curr = prev;
+    }
+
+    atomic_store_explicit(&first->pos, sizeof(CflatConcurrentArenaNode), memory_order_relaxed);
+    atomic_store_explicit(&arena->curr, first, memory_order_release);
+}
+
+void cflat_concurrent_arena_delete(CflatConcurrentArena *arena) {
+    if (arena == NULL) return;
+    CflatConcurrentArenaNode *first = container_of(arena, CflatConcurrentArenaNode, _arena);
+    CflatConcurrentArenaNode *it;
+
+    for (it = arena->free; it;) {
+        CflatConcurrentArenaNode *prev = it->prev;
+        cflat__os_release(it, it->res);
+        it = prev;
+    }
+
+    for (it = atomic_load_explicit(&arena->curr, memory_order_acquire); it != first;) {
+        CflatConcurrentArenaNode *prev = it->prev;
+        cflat__os_release(it, it->res);
+        it = prev;
+    }
+
+    cflat__os_release(first, first->res);
+}
+
+#endif // CFLAT_CONCURRENT_ARENA_IMPLEMENTATION
+#undef CFLAT_CONCURRENT_ARENA_IMPLEMENTATION
+
+#if !defined(CFLAT_CONCURRENT_ARENA_NO_ALIAS)
+
+#   define ConcurrentArena CflatConcurrentArena
+#   define concurrent_arena_new cflat_concurrent_arena_new
+#   define concurrent_arena_new_opt cflat_concurrent_arena_new_opt
+#   define concurrent_arena_push cflat_concurrent_arena_push
+#   define concurrent_arena_push_opt cflat_concurrent_arena_push_opt
+#   define concurrent_arena_push_array cflat_concurrent_arena_push_array
+#   define concurrent_arena_clear cflat_concurrent_arena_clear
+#   define concurrent_arena_delete cflat_concurrent_arena_delete
+
+#endif // CFLAT_CONCURRENT_ARENA_NO_ALIAS
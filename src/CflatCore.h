@@ -201,6 +201,10 @@ typedef SSIZE_T ssize_t;
 #   define cflat_pause
 #endif
 
+#if !defined(CFLAT_CACHE_LINE_SIZE)
+#   define CFLAT_CACHE_LINE_SIZE 64
+#endif
+
 #define cflat_alignofexp(EXP) cflat_alignof(cflat_typeof(EXP))
 #define cflat_sizeof_member(T, member)  sizeof       ( ( (T*) 0)->member             )
 #define cflat_typeof_member(T, member)  cflat_typeof ( ( (T*) 0)->member             )
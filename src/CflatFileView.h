@@ -0,0 +1,270 @@
+#ifndef CFLAT_FILE_VIEW_H
+#define CFLAT_FILE_VIEW_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+#include "CflatSlice.h"
+#include "CflatString.h"
+
+/*
+ Read only view of a file mapped straight from the page cache, nothing is copied and no header is written to it
+ Files bigger than the address space can afford are read through a window that slides over them
+*/
+
+cflat_enum(CflatFileAdvice, u8) {
+    CFLAT_FILE_ADVICE_NORMAL     = 0,
+    CFLAT_FILE_ADVICE_SEQUENTIAL = 1, // Read ahead aggressively and drop pages behind the reader
+    CFLAT_FILE_ADVICE_RANDOM     = 2, // Don't read ahead
+    CFLAT_FILE_ADVICE_WILLNEED   = 3, // Start reading the whole window in now
+};
+
+/*
+@param bytes:     the mapped part of the file, starting at offset, NULL data if the file couldn't be opened
+@param offset:    offset of bytes.data in the file
+@param file_size: size of the whole file
+*/
+typedef struct cflat_file_view {
+    CflatByteSlice bytes;
+    usize offset;
+    usize file_size;
+    usize window;
+    CflatFileAdvice advice;
+    isize handle;
+    void *base;
+    usize mapped;
+} CflatFileView;
+
+/*
+@param window: bytes mapped at a time, rounded up to the mapping granularity, 0 maps the whole file
+@param advice: @inherit(CflatFileAdvice), applied to every window
+*/
+typedef struct cflat_file_view_open_opt {
+    usize window;
+    CflatFileAdvice advice;
+} CflatFileViewOpenOpt;
+
+/*
+Maps the start of the file read only, writing to the view crashes
+An empty file gives an empty view, check bytes.data to tell a missing file apart
+@param path: path to the file, relative or absolute
+@param opt:  @inherit(CflatFileViewOpenOpt)
+*/
+CFLAT_DEF CflatFileView   cflat_file_view_open_opt(const char *path, CflatFileViewOpenOpt opt       );
+
+/*
+Moves the window so the view starts at offset
+@param view:   the view
+@param offset: offset in the file
+@return:       false once offset is past the end of the file or the window can't be mapped
+*/
+CFLAT_DEF bool            cflat_file_view_seek    (CflatFileView *view, usize offset                );
+
+/*
+Moves the window right after the bytes of the view
+@param view: the view
+@return:     false once the whole file was seen
+*/
+CFLAT_DEF bool            cflat_file_view_next    (CflatFileView *view                              );
+
+/*
+Changes the advice given to the os for this window and the next ones
+@param view:   the view
+@param advice: @inherit(CflatFileAdvice)
+*/
+CFLAT_DEF void            cflat_file_view_advise  (CflatFileView *view, CflatFileAdvice advice      );
+
+/*
+The bytes of the view as a string, it is not null terminated
+@param view: the view
+*/
+CFLAT_DEF CflatStringView cflat_file_view_sv      (const CflatFileView *view                        );
+
+/*
+Unmaps the view and closes the file
+@param view: the view
+*/
+CFLAT_DEF void            cflat_file_view_close   (CflatFileView *view                              );
+
+#define cflat_file_view_open(PATH, ...) CFLAT_OPT(cflat_file_view_open_opt((PATH), (CflatFileViewOpenOpt){ .window = 0, __VA_ARGS__ }))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_FILE_VIEW_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_FILE_VIEW_H
+
+#if defined(CFLAT_FILE_VIEW_IMPLEMENTATION)
+
+#if defined(OS_WINDOWS)
+#include <memoryapi.h>
+#include <sysinfoapi.h>
+#include <fileapi.h>
+#include <handleapi.h>
+#elif defined(OS_UNIX)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+// Windows places views on allocation granularity (64 KiB) boundaries of the file, unix on pages
+static usize cflat__os_map_granularity(void) {
+    static usize granularity = 0;
+    if (granularity == 0) {
+        #if defined(OS_WINDOWS)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        granularity = info.dwAllocationGranularity;
+        #elif defined(OS_UNIX)
+        granularity = (usize)sysconf(_SC_PAGESIZE);
+        #else
+        #error Unsupported platform
+        #endif
+    }
+    return granularity;
+}
+
+static void cflat__os_advise(void *ptr, usize size, CflatFileAdvice advice) {
+    #if defined(OS_WINDOWS)
+    if (advice != CFLAT_FILE_ADVICE_WILLNEED) return;
+    WIN32_MEMORY_RANGE_ENTRY range = { .VirtualAddress = ptr, .NumberOfBytes = size };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    #elif defined(OS_UNIX)
+    static const int advices[] = {
+        [CFLAT_FILE_ADVICE_NORMAL]     = MADV_NORMAL,
+        [CFLAT_FILE_ADVICE_SEQUENTIAL] = MADV_SEQUENTIAL,
+        [CFLAT_FILE_ADVICE_RANDOM]     = MADV_RANDOM,
+        [CFLAT_FILE_ADVICE_WILLNEED]   = MADV_WILLNEED,
+    };
+    madvise(ptr, size, advices[advice]);
+    #else
+    #error Unsupported platform
+    #endif
+}
+
+static void cflat__file_view_unmap(CflatFileView *view) {
+    if (view->base == NULL) return;
+    #if defined(OS_WINDOWS)
+    UnmapViewOfFile(view->base);
+    #elif defined(OS_UNIX)
+    munmap(view->base, view->mapped);
+    #endif
+    view->base = NULL;
+    view->mapped = 0;
+}
+
+CflatFileView cflat_file_view_open_opt(const char *path, CflatFileViewOpenOpt opt) {
+    CflatFileView view = {
+        .window = opt.window ? cflat_align_pow2(opt.window, cflat__os_map_granularity()) : 0,
+        .advice = opt.advice,
+        .handle = -1,
+    };
+
+    #if defined(OS_WINDOWS)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return view;
+    LARGE_INTEGER size = {0};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return view;
+    }
+    view.file_size = (usize)size.QuadPart;
+    // Empty files can't be mapped, the mapping keeps the file open on its own
+    HANDLE mapping = view.file_size ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    CloseHandle(file);
+    if (view.file_size && mapping == NULL) return view;
+    view.handle = mapping ? (isize)(uptr)mapping : -1;
+    #elif defined(OS_UNIX)
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return view;
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        close(fd);
+        return view;
+    }
+    view.file_size = (usize)sb.st_size;
+    view.handle = fd;
+    #else
+    #error Unsupported platform
+    #endif
+
+    if (view.file_size == 0) {
+        static byte empty[1];
+        view.bytes = (CflatByteSlice){ .data = empty };
+        return view;
+    }
+    if (!cflat_file_view_seek(&view, 0)) cflat_file_view_close(&view);
+    return view;
+}
+
+bool cflat_file_view_seek(CflatFileView *view, usize offset) {
+    if (offset >= view->file_size) return false;
+
+    const usize begin = offset & ~(cflat__os_map_granularity() - 1);
+    const usize end   = view->window ? cflat_min(begin + view->window, view->file_size) : view->file_size;
+    cflat__file_view_unmap(view);
+    view->bytes = (CflatByteSlice){0};
+
+    #if defined(OS_WINDOWS)
+    void *base = MapViewOfFile((HANDLE)(uptr)view->handle, FILE_MAP_READ, (DWORD)((u64)begin >> 32), (DWORD)begin, end - begin);
+    if (base == NULL) return false;
+    #elif defined(OS_UNIX)
+    void *base = mmap(0, end - begin, PROT_READ, MAP_PRIVATE, (int)view->handle, (off_t)begin);
+    if (base == MAP_FAILED) return false;
+    #endif
+
+    view->base   = base;
+    view->mapped = end - begin;
+    view->offset = offset;
+    view->bytes  = (CflatByteSlice){
+        .data     = (byte*)base + (offset - begin),
+        .length   = end - offset,
+        .capacity = end - offset,
+    };
+    if (view->advice != CFLAT_FILE_ADVICE_NORMAL) cflat__os_advise(view->base, view->mapped, view->advice);
+    return true;
+}
+
+bool cflat_file_view_next(CflatFileView *view) {
+    return cflat_file_view_seek(view, view->offset + view->bytes.length);
+}
+
+void cflat_file_view_advise(CflatFileView *view, CflatFileAdvice advice) {
+    view->advice = advice;
+    if (view->base) cflat__os_advise(view->base, view->mapped, advice);
+}
+
+CflatStringView cflat_file_view_sv(const CflatFileView *view) {
+    return (CflatStringView){ .data = (char*)view->bytes.data, .length = view->bytes.length, .capacity = view->bytes.length };
+}
+
+void cflat_file_view_close(CflatFileView *view) {
+    cflat__file_view_unmap(view);
+    #if defined(OS_WINDOWS)
+    if (view->handle != -1) CloseHandle((HANDLE)(uptr)view->handle);
+    #elif defined(OS_UNIX)
+    if (view->handle != -1) close((int)view->handle);
+    #endif
+    view->handle = -1;
+    view->bytes = (CflatByteSlice){0};
+}
+
+#endif // CFLAT_FILE_VIEW_IMPLEMENTATION
+#undef CFLAT_FILE_VIEW_IMPLEMENTATION
+
+#if !defined(CFLAT_FILE_VIEW_NO_ALIAS)
+
+#   define FileView CflatFileView
+#   define FileAdvice CflatFileAdvice
+#   define FILE_ADVICE_NORMAL CFLAT_FILE_ADVICE_NORMAL
+#   define FILE_ADVICE_SEQUENTIAL CFLAT_FILE_ADVICE_SEQUENTIAL
+#   define FILE_ADVICE_RANDOM CFLAT_FILE_ADVICE_RANDOM
+#   define FILE_ADVICE_WILLNEED CFLAT_FILE_ADVICE_WILLNEED
+#   define file_view_open cflat_file_view_open
+#   define file_view_open_opt cflat_file_view_open_opt
+#   define file_view_seek cflat_file_view_seek
+#   define file_view_next cflat_file_view_next
+#   define file_view_advise cflat_file_view_advise
+#   define file_view_sv cflat_file_view_sv
+#   define file_view_close cflat_file_view_close
+
+#endif // CFLAT_FILE_VIEW_NO_ALIAS
@@ -0,0 +1,174 @@
+#ifndef CFLAT_FRAME_ARENA_H
+#define CFLAT_FRAME_ARENA_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+
+/*
+ Rotating arenas for per frame (or per request) lifetimes
+ Every frame pushes into its own arena, advancing recycles the arena of the oldest frame,
+ so what a frame pushed stays alive while the next frames - 1 frames run
+*/
+
+#if !defined(CFLAT_FRAME_ARENA_MAX)
+#   define CFLAT_FRAME_ARENA_MAX 8
+#endif
+
+/*
+Peak usage of the frames, a frame's peak is the highest position its arena reached
+Without CFLAT_ARENA_STATS arenas don't track their highest position, the position the frame ended at is used instead
+@param frames:     frames that ended
+@param last_peak:  peak of the last frame that ended
+@param max_peak:   highest peak of any frame
+@param total_peak: sum of the peaks, divide by frames for the mean
+*/
+typedef struct cflat_frame_arena_stats {
+    u64 frames;
+    usize last_peak;
+    usize max_peak;
+    usize total_peak;
+} CflatFrameArenaStats;
+
+typedef struct cflat_frame_arena {
+    CflatArena *arenas[CFLAT_FRAME_ARENA_MAX];
+    usize count;
+    usize current;
+    usize keep_warm;
+    CflatFrameArenaStats stats;
+} CflatFrameArena;
+
+/*
+@param frames:    arenas rotated, from 2 up to CFLAT_FRAME_ARENA_MAX, 2 double buffers
+@param reserve:   reserve of every arena, see CflatArenaNewOpt
+@param commit:    commit of every arena, see CflatArenaNewOpt
+@param keep_warm: committed bytes the recycled arena keeps, the rest goes back to the os, 0 keeps everything
+*/
+typedef struct cflat_frame_arena_new_opt {
+    usize frames;
+    usize reserve;
+    usize commit;
+    usize keep_warm;
+} CflatFrameArenaNewOpt;
+
+/*
+Creates the arenas of every frame, the first frame begins right away
+@param opt: @inherit(CflatFrameArenaNewOpt)
+*/
+CFLAT_DEF CflatFrameArena      cflat_frame_arena_new_opt (CflatFrameArenaNewOpt opt                );
+
+/*
+Returns the arena of the current frame
+@param frames: the frame arena
+*/
+CFLAT_DEF CflatArena*          cflat_frame_arena_current (CflatFrameArena *frames                  );
+
+/*
+Returns the arena of an earlier frame that is still alive
+@param frames: the frame arena
+@param age:    how many frames back, 0 is the current one, must be less than the number of frames
+*/
+CFLAT_DEF CflatArena*          cflat_frame_arena_previous(CflatFrameArena *frames, usize age       );
+
+/*
+Ends the current frame and begins the next one in the arena of the oldest frame, which is cleared
+@param frames: the frame arena
+@return:       the arena of the new frame
+*/
+CFLAT_DEF CflatArena*          cflat_frame_arena_advance (CflatFrameArena *frames                  );
+
+/*
+Returns the peak usage of the frames that ended, see CflatFrameArenaStats
+@param frames: the frame arena
+*/
+CFLAT_DEF CflatFrameArenaStats cflat_frame_arena_stats   (CflatFrameArena *frames                  );
+
+/*
+Deletes the arenas of every frame
+@param frames: the frame arena
+*/
+CFLAT_DEF void                 cflat_frame_arena_delete  (CflatFrameArena *frames                  );
+
+#define cflat_frame_arena_new(...) CFLAT_OPT(cflat_frame_arena_new_opt((CflatFrameArenaNewOpt){ .frames = 2, .reserve = CFLAT_DEFAULT_RESERVE_SIZE, .commit = CFLAT_DEFAULT_COMMIT_SIZE, __VA_ARGS__ }))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_FRAME_ARENA_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_FRAME_ARENA_H
+
+#if defined(CFLAT_FRAME_ARENA_IMPLEMENTATION)
+
+CflatFrameArena cflat_frame_arena_new_opt(CflatFrameArenaNewOpt opt) {
+    cflat_assert(opt.frames >= 2 && opt.frames <= CFLAT_FRAME_ARENA_MAX);
+    CflatFrameArena frames = {
+        .count     = opt.frames,
+        .keep_warm = opt.keep_warm,
+    };
+    for (usize i = 0; i < frames.count; ++i) {
+        frames.arenas[i] = cflat_arena_new(.reserve = opt.reserve, .commit = cflat_min(opt.commit, opt.reserve));
+    }
+    return frames;
+}
+
+CflatArena* cflat_frame_arena_current(CflatFrameArena *frames) {
+    return frames->arenas[frames->current];
+}
+
+CflatArena* cflat_frame_arena_previous(CflatFrameArena *frames, usize age) {
+    cflat_assert(age < frames->count);
+    return frames->arenas[(frames->current + frames->count - age) % frames->count];
+}
+
+// The highest position of the current frame, resetting it for the next time its arena is used
+static usize cflat__frame_arena_take_peak(CflatArena *arena) {
+    #if CFLAT_ARENA_STATS
+    const usize peak = cflat_max(arena->stats.peak_pos, arena->pos);
+    arena->stats.peak_pos = 0;
+    return peak;
+    #else
+    return arena->pos;
+    #endif
+}
+
+CflatArena* cflat_frame_arena_advance(CflatFrameArena *frames) {
+    const usize peak = cflat__frame_arena_take_peak(frames->arenas[frames->current]);
+    frames->stats.frames     += 1;
+    frames->stats.last_peak   = peak;
+    frames->stats.max_peak    = cflat_max(frames->stats.max_peak, peak);
+    frames->stats.total_peak += peak;
+
+    frames->current = (frames->current + 1) % frames->count;
+    CflatArena *arena = frames->arenas[frames->current];
+    cflat_arena_clear(arena);
+    if (frames->keep_warm) cflat_arena_trim(arena, frames->keep_warm);
+    return arena;
+}
+
+CflatFrameArenaStats cflat_frame_arena_stats(CflatFrameArena *frames) {
+    return frames->stats;
+}
+
+void cflat_frame_arena_delete(CflatFrameArena *frames) {
+    for (usize i = 0; i < frames->count; ++i) {
+        cflat_arena_delete(frames->arenas[i]);
+        frames->arenas[i] = NULL;
+    }
+    frames->count = 0;
+}
+
+#endif // CFLAT_FRAME_ARENA_IMPLEMENTATION
+#undef CFLAT_FRAME_ARENA_IMPLEMENTATION
+
+#if !defined(CFLAT_FRAME_ARENA_NO_ALIAS)
+
+#   define FrameArena CflatFrameArena
+#   define FrameArenaStats CflatFrameArenaStats
+#   define frame_arena_new cflat_frame_arena_new
+#   define frame_arena_new_opt cflat_frame_arena_new_opt
+#   define frame_arena_current cflat_frame_arena_current
+#   define frame_arena_previous cflat_frame_arena_previous
+#   define frame_arena_advance cflat_frame_arena_advance
+#   define frame_arena_stats cflat_frame_arena_stats
+#   define frame_arena_delete cflat_frame_arena_delete
+
+#endif // CFLAT_FRAME_ARENA_NO_ALIAS
@@ -0,0 +1,206 @@
+#ifndef CFLAT_POOL_H
+#define CFLAT_POOL_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+#include "CflatAllocator.h"
+
+/*
+ Fixed size object pool
+ Slots are carved from the backing allocator a chunk at a time and threaded through an intrusive free list,
+ so any slot can be freed in any order and reused in O(1), the chunks go back to the allocator on cflat_pool_delete
+*/
+typedef struct cflat_pool_slot {
+    struct cflat_pool_slot *next;
+} CflatPoolSlot;
+
+typedef struct cflat_pool_chunk {
+    struct cflat_pool_chunk *prev;
+} CflatPoolChunk;
+
+typedef struct cflat_pool {
+    CflatAllocator allocator;
+    CflatPoolSlot *free;
+    CflatPoolChunk *chunks;
+    usize slot_size;
+    usize align;
+    usize chunk_slots;
+} CflatPool;
+
+/*
+@param align:       alignment of every slot, CFLAT_CACHE_LINE_SIZE keeps slots from sharing a cache line
+@param chunk_slots: how many slots are carved from the allocator when the pool runs out
+*/
+typedef struct cflat_pool_new_opt {
+    usize align;
+    usize chunk_slots;
+} CflatPoolNewOpt;
+
+/*
+Creates a pool of slot_size sized slots, nothing is allocated until the first cflat_pool_alloc
+@param allocator: allocator the chunks are carved from
+@param slot_size: size in bytes of every slot
+@param opt:       @inherit(CflatPoolNewOpt)
+*/
+CFLAT_DEF CflatPool cflat_pool_new_opt (CflatAllocator allocator, usize slot_size, CflatPoolNewOpt opt);
+
+/*
+Returns a slot from the pool, the contents are whatever was left in it
+@param pool: the pool
+*/
+CFLAT_DEF void*     cflat_pool_alloc   (CflatPool *pool                                        );
+
+/*
+Returns a slot to the pool
+@param pool: the pool
+@param ptr:  a slot returned by cflat_pool_alloc, NULL is ignored
+*/
+CFLAT_DEF void      cflat_pool_free    (CflatPool *pool, void *ptr                             );
+
+/*
+Returns every slot to the pool, keeping the chunks
+The chunks must still be alive, a pool whose arena was cleared or popped must be recreated instead
+@param pool: the pool
+*/
+CFLAT_DEF void      cflat_pool_clear   (CflatPool *pool                                        );
+
+/*
+Gives every chunk back to the backing allocator
+@param pool: the pool
+*/
+CFLAT_DEF void      cflat_pool_delete  (CflatPool *pool                                        );
+
+/*
+Allocator handing out the slots of the pool, requests must fit in a slot
+@param pool: the pool
+*/
+CFLAT_DEF CflatAllocator cflat_pool_allocator(CflatPool *pool                                  );
+
+#define CFLAT_DEFAULT_POOL_CHUNK_SLOTS 64
+
+#define cflat_pool_new(ALLOCATOR, SLOT_SIZE, ...)  CFLAT_OPT(cflat_pool_new_opt(cflat_allocator(ALLOCATOR), (SLOT_SIZE), (CflatPoolNewOpt){ .align = cflat_alignof(uptr), .chunk_slots = CFLAT_DEFAULT_POOL_CHUNK_SLOTS, __VA_ARGS__ }))
+#define cflat_pool_new_type(T, ALLOCATOR, ...)     CFLAT_OPT(cflat_pool_new_opt(cflat_allocator(ALLOCATOR), sizeof(T), (CflatPoolNewOpt){ .align = cflat_alignof(T), .chunk_slots = CFLAT_DEFAULT_POOL_CHUNK_SLOTS, __VA_ARGS__ }))
+#define cflat_pool_alloc_type(T, POOL)             ((T*)cflat_pool_alloc((POOL)))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_POOL_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_POOL_H
+
+#if defined(CFLAT_POOL_IMPLEMENTATION)
+
+CflatPool cflat_pool_new_opt(CflatAllocator allocator, usize slot_size, CflatPoolNewOpt opt) {
+    if (opt.align < cflat_alignof(CflatPoolSlot)) opt.align = cflat_alignof(CflatPoolSlot);
+    if (opt.chunk_slots == 0) opt.chunk_slots = CFLAT_DEFAULT_POOL_CHUNK_SLOTS;
+    cflat_assert(cflat_is_pow2(opt.align));
+    slot_size = cflat_max(slot_size, sizeof(CflatPoolSlot));
+    return (CflatPool) {
+        .allocator   = allocator,
+        .slot_size   = cflat_align_pow2(slot_size, opt.align),
+        .align       = opt.align,
+        .chunk_slots = opt.chunk_slots,
+    };
+}
+
+static usize cflat__pool_chunk_size(const CflatPool *pool) {
+    return cflat_align_pow2(sizeof(CflatPoolChunk), pool->align) + pool->chunk_slots * pool->slot_size;
+}
+
+static byte* cflat__pool_chunk_slots(const CflatPool *pool, CflatPoolChunk *chunk) {
+    return (byte*)cflat_align_pow2((uptr)(chunk + 1), pool->align);
+}
+
+// Threads every slot of the chunk onto the free list, last slot first so allocation walks the chunk forward
+static void cflat__pool_chunk_release(CflatPool *pool, CflatPoolChunk *chunk) {
+    byte *slots = cflat__pool_chunk_slots(pool, chunk);
+    for (usize i = pool->chunk_slots; i-- > 0;) {
+        CflatPoolSlot *slot = (CflatPoolSlot*)(slots + i * pool->slot_size);
+        cflat_ll_push(pool->free, slot, next);
+    }
+}
+
+void* cflat_pool_alloc(CflatPool *pool) {
+    if (pool->free == NULL) {
+        CflatPoolChunk *chunk = cflat_allocator_alloc(pool->allocator, cflat__pool_chunk_size(pool), .align = pool->align);
+        if (chunk == NULL) return NULL;
+        cflat_ll_push(pool->chunks, chunk, prev);
+        cflat__pool_chunk_release(pool, chunk);
+    }
+
+    CflatPoolSlot *slot = pool->free;
+    cflat_ll_pop(pool->free, next);
+    return slot;
+}
+
+void cflat_pool_free(CflatPool *pool, void *ptr) {
+    if (ptr == NULL) return;
+    CflatPoolSlot *slot = ptr;
+    cflat_ll_push(pool->free, slot, next);
+}
+
+void cflat_pool_clear(CflatPool *pool) {
+    pool->free = NULL;
+    for (CflatPoolChunk *chunk = pool->chunks; chunk; chunk = chunk->prev) {
+        cflat__pool_chunk_release(pool, chunk);
+    }
+}
+
+void cflat_pool_delete(CflatPool *pool) {
+    const usize chunk_size = cflat__pool_chunk_size(pool);
+    while (pool->chunks) {
+        CflatPoolChunk *chunk = pool->chunks;
+        cflat_ll_pop(pool->chunks, prev);
+        cflat_allocator_free(pool->allocator, chunk, chunk_size);
+    }
+    pool->free = NULL;
+}
+
+static void* cflat__pool_allocator_alloc(void *ctx, usize size, CflatAllocOpt opt) {
+    CflatPool *pool = ctx;
+    cflat_assert(size <= pool->slot_size && opt.align <= pool->align);
+    void *result = cflat_pool_alloc(pool);
+    if (result && opt.clear) cflat_mem_zero(result, size);
+    return result;
+}
+
+static void* cflat__pool_allocator_resize(void *ctx, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt) {
+    CflatPool *pool = ctx;
+    if (ptr == NULL) return cflat__pool_allocator_alloc(ctx, new_size, opt);
+    cflat_assert(new_size <= pool->slot_size && "Pool slots can't grow");
+    if (opt.clear && new_size > old_size) cflat_mem_zero((byte*)ptr + old_size, new_size - old_size);
+    return ptr;
+}
+
+static void cflat__pool_allocator_free(void *ctx, void *ptr, usize size) {
+    (void)size;
+    cflat_pool_free(ctx, ptr);
+}
+
+static const CflatAllocatorVtable cflat__pool_allocator_vtable = {
+    .alloc  = cflat__pool_allocator_alloc,
+    .resize = cflat__pool_allocator_resize,
+    .free   = cflat__pool_allocator_free,
+};
+
+CflatAllocator cflat_pool_allocator(CflatPool *pool) {
+    return (CflatAllocator) { .vtable = &cflat__pool_allocator_vtable, .ctx = pool };
+}
+
+#endif // CFLAT_POOL_IMPLEMENTATION
+#undef CFLAT_POOL_IMPLEMENTATION
+
+#if !defined(CFLAT_POOL_NO_ALIAS)
+
+#   define Pool CflatPool
+#   define pool_new cflat_pool_new
+#   define pool_new_opt cflat_pool_new_opt
+#   define pool_new_type cflat_pool_new_type
+#   define pool_alloc cflat_pool_alloc
+#   define pool_alloc_type cflat_pool_alloc_type
+#   define pool_free cflat_pool_free
+#   define pool_clear cflat_pool_clear
+#   define pool_delete cflat_pool_delete
+#   define pool_allocator cflat_pool_allocator
+
+#endif // CFLAT_POOL_NO_ALIAS
@@ -6,6 +6,8 @@
 #include "CflatSlice.h"
 #include "CflatString.h"
 #include "CflatAppend.h"
+#include "CflatAllocator.h"
+#include "CflatPool.h"
 #include <iso646.h>
 #include <limits.h>
 #include <stdint.h>
@@ -31,7 +33,8 @@ typedef struct cflat_adj_u32 {
 } CflatAdjU32;
 
 typedef struct cflat_nfa {
-    CflatArena    *arena;
+    CflatAllocator allocator;
+    CflatPool     transitions;
     CflatAdjU32   states;
     CflatSliceU32 groups;
     u32           start;
@@ -54,7 +57,11 @@ cflat_enum(CflatMatchOptions, u8) {
     CFLAT_MATCH_EXACT         = CFLAT_MATCH_BEGIN | CFLAT_MATCH_END,
 };
 
-CFLAT_DEF CflatNfa cflat_nfa_new(CflatArena *arena);
+CFLAT_DEF CflatNfa (cflat_nfa_new)(CflatAllocator allocator);
+CFLAT_DEF void cflat_nfa_clear(CflatNfa *nfa);
+CFLAT_DEF void cflat_nfa_delete(CflatNfa *nfa);
+
+#define cflat_nfa_new(ALLOCATOR) (cflat_nfa_new)(cflat_allocator(ALLOCATOR))
 CFLAT_DEF void cflat_nfa_begin_group(CflatNfa *nfa);
 CFLAT_DEF void cflat_nfa_match_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOptions opt); 
 CFLAT_DEF void cflat_nfa_or_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOptions opt);
@@ -66,12 +73,41 @@ CFLAT_DEF bool cflat_nfa_match_next(CflatNfa nfa, CflatStringView *match, const
 
 #ifdef CFLAT_IMPLEMENTATION
 
-CflatNfa cflat_nfa_new(CflatArena *arena) {
-    return (CflatNfa) { .arena = arena };
+CflatNfa (cflat_nfa_new)(CflatAllocator allocator) {
+    return (CflatNfa) {
+        .allocator   = allocator,
+        .transitions = cflat_pool_new_type(CflatAdjNodeU32, allocator),
+    };
+}
+
+// Forgets every pattern, the transitions go back to the pool so rebuilding the nfa does not grow the arena
+void cflat_nfa_clear(CflatNfa *nfa) {
+    cflat_pool_clear(&nfa->transitions);
+    if (nfa->states.data) cflat_mem_zero(nfa->states.data, nfa->states.capacity * sizeof(*nfa->states.data));
+    nfa->states.length = 0;
+    nfa->groups.length = 0;
+    nfa->start         = 0;
+    nfa->nullable      = false;
+}
+
+// Gives the nfa memory back to its allocator
+void cflat_nfa_delete(CflatNfa *nfa) {
+    cflat_pool_delete(&nfa->transitions);
+    cflat_slice_delete(nfa->allocator, &nfa->states);
+    cflat_slice_delete(nfa->allocator, &nfa->groups);
 }
 
-static void cflat__nfa_add_transition(CflatArena *arena, CflatAdjNodeU32 **stack, u32 match, u32 dst) {
-    CflatAdjNodeU32 *node = cflat_arena_push_struct(CflatAdjNodeU32, arena);
+// Only arenas hand out zeroed memory, every state must start without transitions
+static void cflat__nfa_reserve_states(CflatNfa *nfa, usize count) {
+    const usize capacity = nfa->states.capacity;
+    cflat_slice_resize(nfa->allocator, &nfa->states, count);
+    if (nfa->states.capacity > capacity) {
+        cflat_mem_zero(nfa->states.data + capacity, (nfa->states.capacity - capacity) * sizeof(*nfa->states.data));
+    }
+}
+
+static void cflat__nfa_add_transition(CflatPool *transitions, CflatAdjNodeU32 **stack, u32 match, u32 dst) {
+    CflatAdjNodeU32 *node = cflat_pool_alloc_type(CflatAdjNodeU32, transitions);
     node->u = match;
     node->v = dst;
     cflat_ll_push(*stack, node, next);
@@ -85,15 +121,13 @@ static char cflat__flip_case(char c) {
 }
 
 void cflat_nfa_match_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOptions opt) {
-    CflatArena *arena = nfa->arena;
-
     if (nfa->states.length == 0) {
-        cflat_slice_resize(arena, &nfa->states, pattern.length);
         nfa->states.length = 1;
     }
 
     u32 start_state   = (u32)nfa->states.length - 1;
     u32 end_state     = start_state + (u32)pattern.length;
+    cflat__nfa_reserve_states(nfa, end_state + 1);
     
     bool match_any  = (opt & CFLAT_MATCH_ZERO_OR_MORE);
     bool match_0or1 = (opt & CFLAT_MATCH_ZERO_OR_ONE );
@@ -102,7 +136,7 @@ void cflat_nfa_match_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOpt
     bool case_ins   = (opt & CFLAT_CASE_INSENSTIVE   );
 
     if (match_any || match_one) {
-        cflat__nfa_add_transition(arena, &nfa->states.data[start_state], cflat__nfa_epsilon, end_state);
+        cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[start_state], cflat__nfa_epsilon, end_state);
     }
 
     for (usize i = 0; i < pattern.length; ++i) {
@@ -110,17 +144,17 @@ void cflat_nfa_match_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOpt
         u8  c = (u8)pattern.data[i];
         CflatAdjNodeU32 **head = &nfa->states.data[q];
         
-        cflat__nfa_add_transition(arena, head, c, q + 1);
+        cflat__nfa_add_transition(&nfa->transitions, head, c, q + 1);
         if (case_ins) {
             u8 f = cflat__flip_case(c);
             if (f != 0 && f != c) {
-                cflat__nfa_add_transition(arena, head, f, q + 1);
+                cflat__nfa_add_transition(&nfa->transitions, head, f, q + 1);
             }
         }
     }
 
     if (match_any || match_many) {
-        cflat__nfa_add_transition(arena, &nfa->states.data[end_state], cflat__nfa_epsilon, start_state);
+        cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[end_state], cflat__nfa_epsilon, start_state);
     }
 
     if (pattern.length == 0 || match_any || match_0or1) {
@@ -148,7 +182,7 @@ static void cflat__nfa_expand_stack(CflatNfa nfa, u8 *states, u32 *epsilons, usi
 void cflat_nfa_begin_group(CflatNfa *nfa) {
     u32 entry = (nfa->states.length == 0) ? 0 : (u32)nfa->states.length - 1;
 
-    cflat_slice_append(nfa->arena, &nfa->groups, entry);
+    cflat_slice_append(nfa->allocator, &nfa->groups, entry);
 }
 
 void cflat_nfa_end_group_opt(CflatNfa *nfa, CflatPatternOptions opt) {
@@ -166,11 +200,11 @@ void cflat_nfa_end_group_opt(CflatNfa *nfa, CflatPatternOptions opt) {
     bool match_one  = (opt == CFLAT_MATCH_ONE);
 
     if (match_any || match_0or1 || match_one) {
-        cflat__nfa_add_transition(nfa->arena, &nfa->states.data[start], cflat__nfa_epsilon, end);
+        cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[start], cflat__nfa_epsilon, end);
     }
 
     if (match_any || match_many) {
-        cflat__nfa_add_transition(nfa->arena, &nfa->states.data[end], cflat__nfa_epsilon, start);
+        cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[end], cflat__nfa_epsilon, start);
     }
 
     if (match_any || match_0or1) {
@@ -185,8 +219,6 @@ void cflat_nfa_end_group_opt(CflatNfa *nfa, CflatPatternOptions opt) {
 }
 
 void cflat_nfa_or_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOptions opt) {
-    CflatArena *arena = nfa->arena;
-    
     u32 anchor = nfa->start; 
     if (nfa->groups.length > 0) {
         anchor = nfa->groups.data[nfa->groups.length - 1];
@@ -194,23 +226,23 @@ void cflat_nfa_or_opt(CflatNfa *nfa, CflatStringView pattern, CflatPatternOption
 
     u32 lhs_end = (u32)nfa->states.length - 1;
     u32 fork_state = (u32)nfa->states.length;
-    cflat_slice_resize(arena, &nfa->states, nfa->states.length + 1);
+    cflat__nfa_reserve_states(nfa, nfa->states.length + 1);
     nfa->states.length++;
     
-    cflat__nfa_add_transition(arena, &nfa->states.data[fork_state], cflat__nfa_epsilon, anchor);
+    cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[fork_state], cflat__nfa_epsilon, anchor);
 
     u32 rhs_start = (u32)nfa->states.length;
     cflat_nfa_match_opt(nfa, pattern, opt);
     u32 rhs_end = (u32)nfa->states.length - 1;
 
-    cflat__nfa_add_transition(arena, &nfa->states.data[fork_state], cflat__nfa_epsilon, rhs_start);
+    cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[fork_state], cflat__nfa_epsilon, rhs_start);
 
     u32 join_state = (u32)nfa->states.length;
-    cflat_slice_resize(arena, &nfa->states, nfa->states.length + 1);
+    cflat__nfa_reserve_states(nfa, nfa->states.length + 1);
     nfa->states.length++;
 
-    cflat__nfa_add_transition(arena, &nfa->states.data[lhs_end], cflat__nfa_epsilon, join_state);
-    cflat__nfa_add_transition(arena, &nfa->states.data[rhs_end], cflat__nfa_epsilon, join_state);
+    cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[lhs_end], cflat__nfa_epsilon, join_state);
+    cflat__nfa_add_transition(&nfa->transitions, &nfa->states.data[rhs_end], cflat__nfa_epsilon, join_state);
 
     if (nfa->groups.length > 0) {
         nfa->groups.data[nfa->groups.length - 1] = fork_state;
@@ -226,7 +258,8 @@ CflatStringView cflat_nfa_matches(CflatNfa nfa, CflatStringView text) {
         return result;
 
     CflatTempArena temp;
-    cflat_scratch_arena_scope(temp, 1, &nfa.arena) {
+    CflatArena *backing = cflat_allocator_arena(nfa.allocator);
+    cflat_scratch_arena_scope(temp, 1, &backing) {
         u8 *curr_states    = cflat_arena_push_array(u8,    temp.arena, nfa.states.length);
         u8 *next_states    = cflat_arena_push_array(u8,    temp.arena, nfa.states.length);
         char **curr_starts = cflat_arena_push_array(char*, temp.arena, nfa.states.length);
@@ -323,5 +356,7 @@ bool cflat_nfa_match_next(CflatNfa nfa, CflatStringView *match, const CflatStrin
 #   define nfa_match_opt cflat_nfa_match_opt
 #   define nfa_matches cflat_nfa_matches
 #   define nfa_new cflat_nfa_new
+#   define nfa_clear cflat_nfa_clear
+#   define nfa_delete cflat_nfa_delete
 #   define nfa_or_opt cflat_nfa_or_opt
 #endif // CFLAT_CFLAT_REGEX_NO_ALIAS
@@ -3,6 +3,7 @@
 
 #include "CflatCore.h"
 #include "CflatArena.h"
+#include "CflatAllocator.h"
 #include "CflatSlice.h"
 #include <stdatomic.h>
 
@@ -22,13 +23,16 @@ typedef struct cflat_ring_buffer_read_opt {
     bool clear;
 } CflatRingBufferReadOpt;
 
-CFLAT_DEF CflatRingBuffer* cflat_ring_buffer_new_opt(usize element_size, Arena *a, usize length, CflatRingBufferNewOpt opt         );
+CFLAT_DEF CflatRingBuffer* cflat_ring_buffer_new_opt(usize element_size, CflatAllocator a, usize length, CflatRingBufferNewOpt opt);
+CFLAT_DEF void (cflat_ring_buffer_delete)           (CflatAllocator a, CflatRingBuffer *rb, usize element_size                     );
 CFLAT_DEF usize cflat_ring_buffer_count             (CflatRingBuffer *rb                                                           );
 CFLAT_DEF bool cflat_ring_buffer_is_empty           (CflatRingBuffer *rb                                                           );
 CFLAT_DEF void cflat_ring_buffer_clear              (CflatRingBuffer *rb                                                           );
 CFLAT_DEF bool cflat_ring_buffer_write              (CflatRingBuffer *rb, usize element_size, const void *src                      );
 CFLAT_DEF bool cflat_ring_buffer_read_opt           (CflatRingBuffer *rb, usize element_size, void *dst, CflatRingBufferReadOpt opt);
 CFLAT_DEF void cflat_ring_buffer_overwrite          (CflatRingBuffer *rb, usize element_size, const void *src                      );
+#define cflat_ring_buffer_new(element_size, ALLOCATOR, length, ...) CFLAT_OPT(cflat_ring_buffer_new_opt(element_size, cflat_allocator(ALLOCATOR), length, (CflatRingBufferNewOpt){ .align = cflat_alignof(max_align_t), __VA_ARGS__}))
+#define cflat_ring_buffer_delete(ALLOCATOR, rb, element_size) (cflat_ring_buffer_delete)(cflat_allocator(ALLOCATOR), (rb), (element_size))
 #define cflat_ring_buffer_read(rb, element_size, dst, ...) CFLAT_OPT(ring_buffer_read_opt(rb, element_size, dst, (CflatRingBufferReadOpt){ .clear = false, __VA_ARGS__}))
 
 #if defined(CFLAT_IMPLEMENTATION)
@@ -39,11 +43,11 @@ CFLAT_DEF void cflat_ring_buffer_overwrite          (CflatRingBuffer *rb, usize
 
 #if defined(CFLAT_RING_BUFFER_IMPLEMENTATION)
 
-CflatRingBuffer *cflat_ring_buffer_new_opt(usize element_size, Arena *a, usize length, CflatRingBufferNewOpt opt) {
+CflatRingBuffer *cflat_ring_buffer_new_opt(usize element_size, CflatAllocator a, usize length, CflatRingBufferNewOpt opt) {
     
     usize real_length = next_pow2(length);
 
-    CflatRingBuffer *rb = cflat_arena_push_opt(a, real_length * element_size + sizeof(CflatRingBuffer), (CflatAllocOpt) {
+    CflatRingBuffer *rb = cflat_allocator_alloc_opt(a, real_length * element_size + sizeof(CflatRingBuffer), (CflatAllocOpt) {
         .align = opt.align,
         .clear = opt.clear,
     });
@@ -53,6 +57,11 @@ CflatRingBuffer *cflat_ring_buffer_new_opt(usize element_size, Arena *a, usize l
     return rb;
 }
 
+void (cflat_ring_buffer_delete)(CflatAllocator a, CflatRingBuffer *rb, usize element_size) {
+    if (rb == NULL) return;
+    cflat_allocator_free(a, rb, rb->length * element_size + sizeof(CflatRingBuffer));
+}
+
 bool cflat_ring_buffer_is_empty(CflatRingBuffer *rb) {
     
     if (rb == NULL) return true;
@@ -184,6 +193,8 @@ void cflat_ring_buffer_writable_chunks(CflatRingBuffer *rb, usize element_size,
 #   define ring_buffer_clear cflat_ring_buffer_clear
 #   define ring_buffer_read_opt cflat_ring_buffer_read_opt
 #   define ring_buffer_new_opt cflat_ring_buffer_new_opt
+#   define ring_buffer_new cflat_ring_buffer_new
+#   define ring_buffer_delete cflat_ring_buffer_delete
 #   define ring_buffer_readable_chunks cflat_ring_buffer_readable_chunks
 #   define ring_buffer_writable_chunks cflat_ring_buffer_writable_chunks
 
@@ -0,0 +1,150 @@
+#ifndef CFLAT_SEGMENTED_SLICE_H
+#define CFLAT_SEGMENTED_SLICE_H
+
+#include "CflatCore.h"
+#include "CflatBit.h"
+#include "CflatArena.h"
+#include "CflatAllocator.h"
+
+/*
+ Growable array made of segments that never move
+ Segment s holds CFLAT_SEGMENTED_SLICE_FIRST << s elements, growing allocates the next segment and copies nothing,
+ so pointers to elements stay valid for the life of the slice and growing an arena backed one doesn't leave dead copies behind
+ Element i lives in segment log2(i + FIRST) - log2(FIRST)
+ A zero initialized slice is empty and ready to use
+*/
+
+#if !defined(CFLAT_SEGMENTED_SLICE_FIRST)
+#   define CFLAT_SEGMENTED_SLICE_FIRST 16 // Elements in the first segment, a power of two
+#endif
+#define CFLAT_SEGMENTED_SLICE_SEGMENTS 48
+
+#define CFLAT_SEGMENTED_SLICE_FIELDS(T)                  \
+    usize length;                                        \
+    usize capacity;                                      \
+    T *segments[CFLAT_SEGMENTED_SLICE_SEGMENTS]          \
+
+typedef struct cflat_segmented_slice {
+    CFLAT_SEGMENTED_SLICE_FIELDS(byte);
+} CflatSegmentedSlice;
+
+/*
+Allocates the next segment
+@param allocator:    allocator the segments come from
+@param slice:        any CFLAT_SEGMENTED_SLICE_FIELDS struct
+@param element_size: size of an element
+@return:             false if the allocator failed
+*/
+CFLAT_DEF bool  cflat__segmented_slice_grow  (CflatAllocator allocator, void *slice, usize element_size);
+
+/*
+Gives every segment back to the allocator
+@param allocator:    allocator the segments came from
+@param slice:        any CFLAT_SEGMENTED_SLICE_FIELDS struct
+@param element_size: size of an element
+*/
+CFLAT_DEF void  cflat__segmented_slice_delete(CflatAllocator allocator, void *slice, usize element_size);
+
+static inline usize cflat_segmented_slice_segment_of(usize index) {
+    return (usize)cflat_log2_u64((u64)index + CFLAT_SEGMENTED_SLICE_FIRST) - (usize)cflat_log2_u64(CFLAT_SEGMENTED_SLICE_FIRST);
+}
+
+static inline usize cflat_segmented_slice_segment_length(usize segment) {
+    return (usize)CFLAT_SEGMENTED_SLICE_FIRST << segment;
+}
+
+static inline void* cflat__segmented_slice_locate(byte *const *segments, usize element_size, usize index) {
+    const usize segment = cflat_segmented_slice_segment_of(index);
+    const usize offset  = index + CFLAT_SEGMENTED_SLICE_FIRST - cflat_segmented_slice_segment_length(segment);
+    return segments[segment] + offset * element_size;
+}
+
+#define cflat_segmented_slice_at(SS, INDEX)                                                                                      \
+    ((cflat_typeof((SS).segments[0]))cflat__segmented_slice_locate((byte *const *)(SS).segments, sizeof(*(SS).segments[0]),      \
+                                                                   cflat_bounds_check((INDEX), (SS).length)))
+
+// Makes room for one more element, evaluates to false if the allocator failed
+#define cflat_segmented_slice_reserve_one(ALLOCATOR, SS)                                                                         \
+    ((SS)->length < (SS)->capacity || cflat__segmented_slice_grow(cflat_allocator(ALLOCATOR), (SS), sizeof(*(SS)->segments[0])))
+
+#define cflat_segmented_slice_append(ALLOCATOR, SS, VAL)                                                                         \
+    do {                                                                                                                         \
+        if (cflat_segmented_slice_reserve_one((ALLOCATOR), (SS))) {                                                              \
+            (SS)->length += 1;                                                                                                   \
+            *cflat_segmented_slice_at(*(SS), (SS)->length - 1) = (VAL);                                                          \
+        }                                                                                                                        \
+    } while (0)
+
+#define cflat_segmented_slice_emplace(ALLOCATOR, SS, ...)                                                                        \
+    cflat_segmented_slice_append((ALLOCATOR), (SS), ((cflat_typeof(*(SS)->segments[0])){__VA_ARGS__}))
+
+// Grows the slice until it can hold CAPACITY elements
+#define cflat_segmented_slice_reserve(ALLOCATOR, SS, CAPACITY)                                                                   \
+    do {                                                                                                                         \
+        const usize cflat__capacity = (CAPACITY);                                                                                \
+        while ((SS)->capacity < cflat__capacity                                                                                  \
+            && cflat__segmented_slice_grow(cflat_allocator(ALLOCATOR), (SS), sizeof(*(SS)->segments[0])));                       \
+    } while (0)
+
+// Forgets the elements, keeping the segments
+#define cflat_segmented_slice_clear(SS) ((SS)->length = 0)
+
+#define cflat_segmented_slice_delete(ALLOCATOR, SS)                                                                              \
+    cflat__segmented_slice_delete(cflat_allocator(ALLOCATOR), (SS), sizeof(*(SS)->segments[0]))
+
+// Visits the elements a segment at a time, PTR and LEN name the contiguous run of the current segment
+#define cflat_segmented_slice_for_each_segment(SS, PTR, LEN)                                                                     \
+    for (usize CONCAT(_s, __LINE__) = 0, CONCAT(_seen, __LINE__) = 0; CONCAT(_seen, __LINE__) < (SS).length;                     \
+         CONCAT(_seen, __LINE__) += cflat_segmented_slice_segment_length(CONCAT(_s, __LINE__)++))                                \
+    for (cflat_typeof((SS).segments[0]) PTR = (SS).segments[CONCAT(_s, __LINE__)]; PTR; PTR = NULL)                             \
+    for (usize LEN = cflat_min(cflat_segmented_slice_segment_length(CONCAT(_s, __LINE__)), (SS).length - CONCAT(_seen, __LINE__)); PTR; PTR = NULL)
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_SEGMENTED_SLICE_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_SEGMENTED_SLICE_H
+
+#if defined(CFLAT_SEGMENTED_SLICE_IMPLEMENTATION)
+
+bool cflat__segmented_slice_grow(CflatAllocator allocator, void *slice, usize element_size) {
+    CflatSegmentedSlice *ss = slice;
+    const usize segment = ss->capacity ? cflat_segmented_slice_segment_of(ss->capacity) : 0;
+    cflat_assert(segment < CFLAT_SEGMENTED_SLICE_SEGMENTS);
+    const usize length = cflat_segmented_slice_segment_length(segment);
+    byte *data = cflat_allocator_alloc_opt(allocator, length * element_size, (CflatAllocOpt){ .align = cflat_alignof(max_align_t) });
+    if (data == NULL) return false;
+    ss->segments[segment] = data;
+    ss->capacity += length;
+    return true;
+}
+
+void cflat__segmented_slice_delete(CflatAllocator allocator, void *slice, usize element_size) {
+    CflatSegmentedSlice *ss = slice;
+    // Newest first, an arena gets each one back from its top
+    for (usize segment = CFLAT_SEGMENTED_SLICE_SEGMENTS; segment-- > 0;) {
+        if (ss->segments[segment] == NULL) continue;
+        cflat_allocator_free(allocator, ss->segments[segment], cflat_segmented_slice_segment_length(segment) * element_size);
+        ss->segments[segment] = NULL;
+    }
+    ss->length = ss->capacity = 0;
+}
+
+#endif // CFLAT_SEGMENTED_SLICE_IMPLEMENTATION
+#undef CFLAT_SEGMENTED_SLICE_IMPLEMENTATION
+
+#if !defined(CFLAT_SEGMENTED_SLICE_NO_ALIAS)
+
+#   define SegmentedSlice CflatSegmentedSlice
+#   define segmented_slice_at cflat_segmented_slice_at
+#   define segmented_slice_append cflat_segmented_slice_append
+#   define segmented_slice_emplace cflat_segmented_slice_emplace
+#   define segmented_slice_reserve cflat_segmented_slice_reserve
+#   define segmented_slice_reserve_one cflat_segmented_slice_reserve_one
+#   define segmented_slice_clear cflat_segmented_slice_clear
+#   define segmented_slice_delete cflat_segmented_slice_delete
+#   define segmented_slice_for_each_segment cflat_segmented_slice_for_each_segment
+#   define segmented_slice_segment_of cflat_segmented_slice_segment_of
+#   define segmented_slice_segment_length cflat_segmented_slice_segment_length
+
+#endif // CFLAT_SEGMENTED_SLICE_NO_ALIAS
@@ -0,0 +1,305 @@
+#ifndef CFLAT_SLAB_H
+#define CFLAT_SLAB_H
+
+#include <stdatomic.h>
+#include "CflatCore.h"
+#include "CflatBit.h"
+#include "CflatArena.h"
+#include "CflatAllocator.h"
+
+/*
+ General purpose allocator for small objects that can be freed in any order
+ Requests are rounded up to one of CFLAT_SLAB_CLASS_COUNT size classes, every class is carved from arena chunks
+ Each thread keeps a magazine of free slots per class so most allocations and frees touch no shared state,
+ magazines are refilled from and flushed to a shared depot in batches
+ Requests bigger than the largest class go straight to the os
+*/
+
+#define CFLAT_SLAB_CLASS_COUNT    16
+#define CFLAT_SLAB_MAX_SIZE       KiB(4)
+#define CFLAT_SLAB_MAGAZINE_SIZE  32
+#define CFLAT_SLAB_MAX_THREADS    64
+#define CFLAT_SLAB_CHUNK_SIZE     KiB(64)
+
+typedef struct cflat_slab_slot {
+    struct cflat_slab_slot *next;
+} CflatSlabSlot;
+
+typedef struct cflat_slab_magazine {
+    usize count;
+    void *slots[CFLAT_SLAB_MAGAZINE_SIZE];
+} CflatSlabMagazine;
+
+// The magazines of the threads that map to the same row, only contended past CFLAT_SLAB_MAX_THREADS threads
+typedef struct cflat_slab_row {
+    atomic_flag lock;
+    CflatSlabMagazine magazines[CFLAT_SLAB_CLASS_COUNT];
+} CflatSlabRow;
+
+typedef struct cflat_slab_class {
+    CflatSlabSlot *depot;
+    byte *cursor;
+    byte *end;
+} CflatSlabClass;
+
+typedef struct cflat_slab_allocator {
+    CflatArena *arena;
+    atomic_flag lock; // Guards the arena, the classes and the creation of rows
+    CflatSlabClass classes[CFLAT_SLAB_CLASS_COUNT];
+    _Atomic(CflatSlabRow*) rows[CFLAT_SLAB_MAX_THREADS];
+} CflatSlabAllocator;
+
+/*
+Creates a slab allocator carving its memory from the arena, NULL if the arena has no room for it
+The arena must not be used by anything else while the slab allocator is alive
+@param arena: the backing arena
+*/
+CFLAT_DEF CflatSlabAllocator* cflat_slab_new       (CflatArena *arena                                 );
+
+/*
+Allocates size bytes, aligned to 16 bytes, NULL once the arena is full and no slot of the class is free
+@param slab: the slab allocator
+@param size: size in bytes
+*/
+CFLAT_DEF void*               cflat_slab_alloc     (CflatSlabAllocator *slab, usize size              );
+
+/*
+Returns memory to the slab allocator
+@param slab: the slab allocator
+@param ptr:  memory returned by cflat_slab_alloc, NULL is ignored
+@param size: the size it was allocated with
+*/
+CFLAT_DEF void                cflat_slab_free      (CflatSlabAllocator *slab, void *ptr, usize size   );
+
+/*
+Returns the size class a request of size bytes is served from
+@param size: size in bytes, at most CFLAT_SLAB_MAX_SIZE
+*/
+CFLAT_DEF usize               cflat_slab_class_of  (usize size                                        );
+
+/*
+Returns how many bytes a slot of the size class holds
+@param size_class: a value returned by cflat_slab_class_of
+*/
+CFLAT_DEF usize               cflat_slab_class_size(usize size_class                                  );
+
+/*
+Allocator backed by the slab allocator, alignments up to 16 bytes
+@param slab: the slab allocator
+*/
+CFLAT_DEF CflatAllocator      cflat_slab_allocator (CflatSlabAllocator *slab                          );
+
+#define cflat_slab_alloc_type(T, SLAB)    ((T*)cflat_slab_alloc((SLAB), sizeof(T)))
+#define cflat_slab_free_type(T, SLAB, P)  cflat_slab_free((SLAB), (P), sizeof(T))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_SLAB_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_SLAB_H
+
+#if defined(CFLAT_SLAB_IMPLEMENTATION)
+
+// 16 byte steps up to 64, then two classes per power of two
+static const u16 cflat__slab_class_sizes[CFLAT_SLAB_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096,
+};
+
+static atomic_uint cflat__slab_next_thread = 0;
+cflat_thread_local static usize cflat__slab_thread = (usize)-1;
+
+usize cflat_slab_class_of(usize size) {
+    cflat_assert(size <= CFLAT_SLAB_MAX_SIZE);
+    if (size <= 64) return size == 0 ? 0 : (size - 1) / 16;
+    const usize log = (usize)cflat_log2_u64(size - 1);
+    const usize half = (size - 1) >= ((usize)3 << (log - 1));
+    return 4 + (log - 6) * 2 + half;
+}
+
+usize cflat_slab_class_size(usize size_class) {
+    return cflat__slab_class_sizes[size_class];
+}
+
+static void cflat__slab_lock(atomic_flag *lock) {
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire)) cflat_pause();
+}
+
+static void cflat__slab_unlock(atomic_flag *lock) {
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+CflatSlabAllocator* cflat_slab_new(CflatArena *arena) {
+    CflatSlabAllocator *slab = cflat_arena_push(arena, sizeof(CflatSlabAllocator), .align = CFLAT_CACHE_LINE_SIZE, .clear = true);
+    if (slab == NULL) return NULL;
+    slab->arena = arena;
+    atomic_flag_clear(&slab->lock);
+    return slab;
+}
+
+static CflatSlabRow* cflat__slab_row(CflatSlabAllocator *slab) {
+    if (cflat__slab_thread == (usize)-1) {
+        cflat__slab_thread = atomic_fetch_add_explicit(&cflat__slab_next_thread, 1, memory_order_relaxed) % CFLAT_SLAB_MAX_THREADS;
+    }
+
+    _Atomic(CflatSlabRow*) *row_ptr = &slab->rows[cflat__slab_thread];
+    CflatSlabRow *row = atomic_load_explicit(row_ptr, memory_order_acquire);
+    if (cflat_likely(row != NULL)) return row;
+
+    cflat__slab_lock(&slab->lock);
+    row = atomic_load_explicit(row_ptr, memory_order_relaxed);
+    if (row == NULL) {
+        row = cflat_arena_push(slab->arena, sizeof(CflatSlabRow), .align = CFLAT_CACHE_LINE_SIZE, .clear = true);
+        if (row) {
+            atomic_flag_clear(&row->lock);
+            atomic_store_explicit(row_ptr, row, memory_order_release);
+        }
+    }
+    cflat__slab_unlock(&slab->lock);
+    return row;
+}
+
+// Fills half the magazine from the depot, carving new slots once the depot runs dry
+static void cflat__slab_refill(CflatSlabAllocator *slab, usize size_class, CflatSlabMagazine *magazine) {
+    CflatSlabClass *class = &slab->classes[size_class];
+    const usize slot_size = cflat__slab_class_sizes[size_class];
+
+    cflat__slab_lock(&slab->lock);
+    while (magazine->count < CFLAT_SLAB_MAGAZINE_SIZE / 2) {
+        if (class->depot) {
+            magazine->slots[magazine->count++] = class->depot;
+            cflat_ll_pop(class->depot, next);
+            continue;
+        }
+        if ((usize)(class->end - class->cursor) < slot_size) {
+            byte *chunk = cflat_arena_push(slab->arena, CFLAT_SLAB_CHUNK_SIZE, .align = 16);
+            if (chunk == NULL) {
+                // The arena is full, left empty so the next refill tries the arena again instead of carving from NULL
+                class->cursor = class->end = NULL;
+                break;
+            }
+            class->cursor = chunk;
+            class->end = chunk + CFLAT_SLAB_CHUNK_SIZE;
+        }
+        magazine->slots[magazine->count++] = class->cursor;
+        class->cursor += slot_size;
+    }
+    cflat__slab_unlock(&slab->lock);
+}
+
+// Moves the older half of a full magazine to the depot
+static void cflat__slab_flush(CflatSlabAllocator *slab, usize size_class, CflatSlabMagazine *magazine) {
+    const usize half = CFLAT_SLAB_MAGAZINE_SIZE / 2;
+    CflatSlabSlot *first = magazine->slots[0];
+    CflatSlabSlot *last  = first;
+    for (usize i = 1; i < half; ++i) {
+        last->next = magazine->slots[i];
+        last = last->next;
+    }
+
+    cflat__slab_lock(&slab->lock);
+    last->next = slab->classes[size_class].depot;
+    slab->classes[size_class].depot = first;
+    cflat__slab_unlock(&slab->lock);
+
+    cflat_mem_move(magazine->slots, magazine->slots + half, (magazine->count - half) * sizeof(*magazine->slots));
+    magazine->count -= half;
+}
+
+static void* cflat__slab_alloc_large(usize size) {
+    const usize total = cflat_align_pow2(size, cflat__os_page_size());
+    void *result = cflat__os_reserve(total);
+    if (result) cflat__os_commit(result, total);
+    return result;
+}
+
+void* cflat_slab_alloc(CflatSlabAllocator *slab, usize size) {
+    if (size > CFLAT_SLAB_MAX_SIZE) return cflat__slab_alloc_large(size);
+
+    const usize size_class = cflat_slab_class_of(size);
+    CflatSlabRow *row = cflat__slab_row(slab);
+    if (row == NULL) return NULL;
+    CflatSlabMagazine *magazine = &row->magazines[size_class];
+
+    cflat__slab_lock(&row->lock);
+    if (magazine->count == 0) cflat__slab_refill(slab, size_class, magazine);
+    void *result = magazine->count ? magazine->slots[--magazine->count] : NULL;
+    cflat__slab_unlock(&row->lock);
+    return result;
+}
+
+void cflat_slab_free(CflatSlabAllocator *slab, void *ptr, usize size) {
+    if (ptr == NULL) return;
+    if (size > CFLAT_SLAB_MAX_SIZE) {
+        cflat__os_release(ptr, cflat_align_pow2(size, cflat__os_page_size()));
+        return;
+    }
+
+    const usize size_class = cflat_slab_class_of(size);
+    CflatSlabRow *row = cflat__slab_row(slab);
+    if (row == NULL) {
+        // No room for this thread's magazines, the slot goes straight to the depot
+        CflatSlabSlot *slot = ptr;
+        cflat__slab_lock(&slab->lock);
+        slot->next = slab->classes[size_class].depot;
+        slab->classes[size_class].depot = slot;
+        cflat__slab_unlock(&slab->lock);
+        return;
+    }
+    CflatSlabMagazine *magazine = &row->magazines[size_class];
+
+    cflat__slab_lock(&row->lock);
+    if (magazine->count == CFLAT_SLAB_MAGAZINE_SIZE) cflat__slab_flush(slab, size_class, magazine);
+    magazine->slots[magazine->count++] = ptr;
+    cflat__slab_unlock(&row->lock);
+}
+
+static void* cflat__slab_allocator_alloc(void *ctx, usize size, CflatAllocOpt opt) {
+    cflat_assert(opt.align <= 16 || size > CFLAT_SLAB_MAX_SIZE);
+    void *result = cflat_slab_alloc(ctx, size);
+    if (result && opt.clear) cflat_mem_zero(result, size);
+    return result;
+}
+
+static void cflat__slab_allocator_free(void *ctx, void *ptr, usize size) {
+    cflat_slab_free(ctx, ptr, size);
+}
+
+static void* cflat__slab_allocator_resize(void *ctx, void *ptr, usize old_size, usize new_size, CflatAllocOpt opt) {
+    if (ptr == NULL) return cflat__slab_allocator_alloc(ctx, new_size, opt);
+    const bool small = old_size <= CFLAT_SLAB_MAX_SIZE && new_size <= CFLAT_SLAB_MAX_SIZE;
+    if (small && cflat_slab_class_of(old_size) == cflat_slab_class_of(new_size)) {
+        if (opt.clear && new_size > old_size) cflat_mem_zero((byte*)ptr + old_size, new_size - old_size);
+        return ptr;
+    }
+    void *result = cflat__slab_allocator_alloc(ctx, new_size, opt);
+    if (result) cflat_mem_copy(result, ptr, cflat_min(old_size, new_size));
+    cflat_slab_free(ctx, ptr, old_size);
+    return result;
+}
+
+static const CflatAllocatorVtable cflat__slab_allocator_vtable = {
+    .alloc  = cflat__slab_allocator_alloc,
+    .resize = cflat__slab_allocator_resize,
+    .free   = cflat__slab_allocator_free,
+};
+
+CflatAllocator cflat_slab_allocator(CflatSlabAllocator *slab) {
+    return (CflatAllocator) { .vtable = &cflat__slab_allocator_vtable, .ctx = slab };
+}
+
+#endif // CFLAT_SLAB_IMPLEMENTATION
+#undef CFLAT_SLAB_IMPLEMENTATION
+
+#if !defined(CFLAT_SLAB_NO_ALIAS)
+
+#   define SlabAllocator CflatSlabAllocator
+#   define slab_new cflat_slab_new
+#   define slab_alloc cflat_slab_alloc
+#   define slab_free cflat_slab_free
+#   define slab_alloc_type cflat_slab_alloc_type
+#   define slab_free_type cflat_slab_free_type
+#   define slab_class_of cflat_slab_class_of
+#   define slab_class_size cflat_slab_class_size
+#   define slab_allocator cflat_slab_allocator
+
+#endif // CFLAT_SLAB_NO_ALIAS
@@ -4,6 +4,7 @@
 #include "CflatBit.h"
 #include "CflatCore.h"
 #include "CflatArena.h"
+#include "CflatAllocator.h"
 
 #define CFLAT_SLICE_HEADER_FIELDS\
     usize capacity;              \
@@ -13,6 +14,22 @@
     CFLAT_SLICE_HEADER_FIELDS;   \
     T     *data                  \
 
+// Slice whose data is a CflatRelPtr, for slices stored inside the arena they point into
+#define CFLAT_REL_SLICE_FIELDS(T)\
+    CFLAT_SLICE_HEADER_FIELDS;   \
+    CflatRelPtr(T) data          \
+
+/*
+ Slice with room for N elements inside of itself, it only allocates once it outgrows them
+ The data pointer points at inline_data until then, so cflat_slice_at, cflat_subslice and friends work on it as they are
+ Grow it only with the cflat_small_slice_* macros and don't copy it while it is inline, the copy would point into the original
+*/
+#define CFLAT_SMALL_SLICE_FIELDS(T, N) \
+    CFLAT_SLICE_FIELDS(T);             \
+    T inline_data[N]                   \
+
+#define CFLAT_SMALL_SLICE(T, N) struct { CFLAT_SMALL_SLICE_FIELDS(T, N); }
+
 typedef struct cflat_slice_new_opt {
     usize capacity;
     usize align;
@@ -23,9 +40,13 @@ typedef struct cflat_slice_byte {
     CFLAT_SLICE_FIELDS(byte); 
 } CflatByteSlice;
 
-#define cflat_slice_new(TSlice, ARENA, LEN, ...) cflat_lvalue_cast(CflatByteSlice, TSlice) {                                            \
+typedef struct cflat_rel_slice_byte {
+    CFLAT_REL_SLICE_FIELDS(byte);
+} CflatRelByteSlice;
+
+#define cflat_slice_new(TSlice, ALLOCATOR, LEN, ...) cflat_lvalue_cast(CflatByteSlice, TSlice) {                                            \
     CFLAT_OPT(cflat__slice_new_opt( (cflat_sizeof_member(TSlice, data[0])),                                                             \
-                          (ARENA),                                                                                                      \
+                          cflat_allocator(ALLOCATOR),                                                                                   \
                           (LEN),                                                                                                        \
                           (CflatSliceNewOpt){ .capacity = 4, .align = cflat_alignof_member(TSlice, data[0]), __VA_ARGS__}              \
     ))                                                                                                                                  \
@@ -49,9 +70,44 @@ typedef struct cflat_slice_byte {
 #define cflat_slice_data(SLICE)       (SLICE).data
 #define cflat_slice_at(SLICE, INDEX)  ( (SLICE).data + cflat_bounds_check( (INDEX), (SLICE).length) )
 
-CflatByteSlice cflat__slice_new_opt(usize element_size, CflatArena *a, usize length, CflatSliceNewOpt opt);
+// Converts a slice to and from its relative twin, BASE is the address the offsets are taken from
+#define cflat_rel_slice_from(TRelSlice, BASE, SLICE) ((TRelSlice) {                                                                     \
+    .capacity    = (SLICE).capacity,                                                                                                    \
+    .length      = (SLICE).length,                                                                                                      \
+    .data.offset = cflat__rel_offset((BASE), (SLICE).data),                                                                             \
+})
+
+#define cflat_rel_slice_get(TSlice, BASE, REL_SLICE) ((TSlice) {                                                                        \
+    .capacity = (REL_SLICE).capacity,                                                                                                   \
+    .length   = (REL_SLICE).length,                                                                                                     \
+    .data     = cflat_rel_get((BASE), (REL_SLICE).data),                                                                                \
+})
+
+#define cflat_rel_slice_at(BASE, REL_SLICE, INDEX) ( cflat_rel_get((BASE), (REL_SLICE).data) + cflat_bounds_check( (INDEX), (REL_SLICE).length) )
+
+CflatByteSlice cflat__slice_new_opt(usize element_size, CflatAllocator allocator, usize length, CflatSliceNewOpt opt);
 CFLAT_DEF CflatByteSlice cflat__subslice(usize element_size, const CflatByteSlice *s, isize offset, isize length);
 
+/*
+ A slice owns capacity * element_size bytes of its allocator, growing hands those to cflat_allocator_resize
+ slice is any CFLAT_SLICE_FIELDS struct, they all share the layout of CflatByteSlice
+*/
+CFLAT_DEF void cflat__slice_grow       (CflatAllocator allocator, void *slice, usize element_size, usize capacity);
+CFLAT_DEF void cflat__slice_append_many(CflatAllocator allocator, void *slice, usize element_size, const void *src, usize count);
+
+/*
+Grows a small slice so it can hold needed elements, moving it out of its inline storage when that is too small
+@param slice:           any CFLAT_SMALL_SLICE_FIELDS struct
+@param inline_data:     its inline storage
+@param inline_capacity: elements the inline storage holds
+*/
+CFLAT_DEF void cflat__small_slice_grow (CflatAllocator allocator, void *slice, void *inline_data, usize inline_capacity, usize element_size, usize needed);
+
+// Doubles the capacity, or jumps straight to what is needed when doubling is not enough
+static inline usize cflat__slice_grown_capacity(usize capacity, usize needed) {
+    return cflat_max(cflat_max(capacity * 2, (usize)4), needed);
+}
+
 #if defined(CFLAT_IMPLEMENTATION)
 #define CFLAT_SLICE_IMPLEMENTATION
 #endif
@@ -75,24 +131,75 @@ CflatByteSlice cflat__subslice(const usize element_size, const CflatByteSlice *s
     return slice;
 }
 
-CflatByteSlice cflat__slice_new_opt(usize element_size, CflatArena *a, usize length, CflatSliceNewOpt opt) {
+CflatByteSlice cflat__slice_new_opt(usize element_size, CflatAllocator allocator, usize length, CflatSliceNewOpt opt) {
     const usize hint     = cflat_max(length, opt.capacity);
     const usize capacity = cflat_next_pow2_u64(hint);
     const usize size     = capacity*element_size;
     CflatByteSlice slice = {
-        .data = cflat_arena_push_opt(a, size, (CflatAllocOpt){opt.align, opt.clear}),
+        .data = cflat_allocator_alloc_opt(allocator, size, (CflatAllocOpt){opt.align, opt.clear}),
         .length = length,
         .capacity = capacity,
     };
     return slice;
 }
 
+void cflat__slice_grow(CflatAllocator allocator, void *slice, usize element_size, usize capacity) {
+    CflatByteSlice *s = slice;
+    if (capacity <= s->capacity) return;
+    const CflatAllocOpt alloc_opt = { .align = cflat_alignof(max_align_t), .clear = false };
+    s->data = cflat_allocator_resize_opt(allocator, s->data, s->capacity * element_size, capacity * element_size, alloc_opt);
+    s->capacity = capacity;
+}
+
+void cflat__slice_append_many(CflatAllocator allocator, void *slice, usize element_size, const void *src, usize count) {
+    CflatByteSlice *s = slice;
+    if (count == 0) return;
+    const usize length = s->length + count;
+    if (length > s->capacity) {
+        // src can be part of the slice itself, it moves along with it
+        const uptr begin = (uptr)s->data, end = begin + s->capacity * element_size;
+        const bool inside = (uptr)src >= begin && (uptr)src < end;
+        const usize offset = inside ? (usize)((uptr)src - begin) : 0;
+        cflat__slice_grow(allocator, s, element_size, cflat__slice_grown_capacity(s->capacity, length));
+        if (inside) src = s->data + offset;
+    }
+    cflat_mem_copy(s->data + s->length * element_size, src, count * element_size);
+    s->length = length;
+}
+
+void cflat__small_slice_grow(CflatAllocator allocator, void *slice, void *inline_data, usize inline_capacity, usize element_size, usize needed) {
+    CflatByteSlice *s = slice;
+    const bool spilled = s->data != NULL && s->data != inline_data;
+    if (needed <= s->capacity) return;
+    if (!spilled && needed <= inline_capacity) {
+        s->data = inline_data;
+        s->capacity = inline_capacity;
+        return;
+    }
+
+    const usize capacity = cflat__slice_grown_capacity(cflat_max(s->capacity, inline_capacity), needed);
+    const CflatAllocOpt alloc_opt = { .align = cflat_alignof(max_align_t), .clear = false };
+    if (spilled) {
+        s->data = cflat_allocator_resize_opt(allocator, s->data, s->capacity * element_size, capacity * element_size, alloc_opt);
+    } else {
+        byte *data = cflat_allocator_alloc_opt(allocator, capacity * element_size, alloc_opt);
+        if (data && s->length) cflat_mem_copy(data, inline_data, s->length * element_size);
+        s->data = data;
+    }
+    s->capacity = capacity;
+}
+
 #endif // CFLAT_SLICE_IMPLEMENTATION
 #undef CFLAT_SLICE_IMPLEMENTATION
 
 #ifndef CFLAT_SLICE_NO_ALIAS
 
 #   define ByteSlice CflatByteSlice
+#   define RelByteSlice CflatRelByteSlice
+#   define SMALL_SLICE CFLAT_SMALL_SLICE
+#   define rel_slice_from cflat_rel_slice_from
+#   define rel_slice_get cflat_rel_slice_get
+#   define rel_slice_at cflat_rel_slice_at
 #   define slice_data cflat_slice_data
 #   define slice_new cflat_slice_new
 #   define slice_length cflat_slice_length
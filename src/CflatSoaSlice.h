@@ -0,0 +1,199 @@
+#ifndef CFLAT_SOA_SLICE_H
+#define CFLAT_SOA_SLICE_H
+
+#include "CflatCore.h"
+#include "CflatBit.h"
+#include "CflatArena.h"
+#include "CflatAllocator.h"
+#include "CflatSlice.h"
+
+/*
+ Struct of arrays slices, every field gets its own column so a loop over one field only pulls that field into cache
+ ```c
+ CFLAT_SOA_SLICE(Particles, (f32, x), (f32, y), (u32, id));
+
+ Particles ps = {0};
+ cflat_soa_slice_append(Particles, arena, &ps, .x = 1, .y = 2, .id = 3);
+ for (usize i = 0; i < ps.length; i += 8) sum = cflat_add_v256f(sum, cflat_load_v256f(ps.x + i));
+ ```
+ The columns share one allocation, each starts on a CFLAT_SOA_COLUMN_ALIGN boundary and is padded to a multiple of it,
+ so aligned vector loads are valid on every column and may read a whole vector past length
+ CFLAT_SOA_SLICE also declares NameRow, the struct of one row
+*/
+
+#if !defined(CFLAT_SOA_COLUMN_ALIGN)
+#   define CFLAT_SOA_COLUMN_ALIGN CFLAT_CACHE_LINE_SIZE
+#endif
+#define CFLAT_SOA_MAX_COLUMNS 16
+
+/*
+Grows the columns of a soa slice to new_capacity rows, moving the first length rows of each
+@param allocator:    allocator the block comes from
+@param columns:      the column pointers, the first one is the start of the block, updated in place
+@param sizes:        element size of every column
+@param count:        number of columns
+@param capacity:     rows the block holds now
+@param length:       rows in use
+@param new_capacity: rows the block should hold
+@return:             false if the allocator failed, the columns are left as they were
+*/
+CFLAT_DEF bool cflat__soa_slice_grow(CflatAllocator allocator, byte **columns, const usize *sizes, usize count, usize capacity, usize length, usize new_capacity);
+
+/*
+Gives the block of a soa slice back to its allocator
+*/
+CFLAT_DEF void cflat__soa_slice_free(CflatAllocator allocator, byte *block, const usize *sizes, usize count, usize capacity);
+
+#define CFLAT__SOA_NARGS(...) CFLAT__SOA_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define CFLAT__SOA_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+
+// Applies F to every (type, name) pair
+#define CFLAT__SOA_EACH(F, ...) CONCAT(CFLAT__SOA_EACH_, CFLAT__SOA_NARGS(__VA_ARGS__))(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_1(F, P)       F P
+#define CFLAT__SOA_EACH_2(F, P, ...)  F P CFLAT__SOA_EACH_1(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_3(F, P, ...)  F P CFLAT__SOA_EACH_2(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_4(F, P, ...)  F P CFLAT__SOA_EACH_3(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_5(F, P, ...)  F P CFLAT__SOA_EACH_4(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_6(F, P, ...)  F P CFLAT__SOA_EACH_5(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_7(F, P, ...)  F P CFLAT__SOA_EACH_6(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_8(F, P, ...)  F P CFLAT__SOA_EACH_7(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_9(F, P, ...)  F P CFLAT__SOA_EACH_8(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_10(F, P, ...) F P CFLAT__SOA_EACH_9(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_11(F, P, ...) F P CFLAT__SOA_EACH_10(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_12(F, P, ...) F P CFLAT__SOA_EACH_11(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_13(F, P, ...) F P CFLAT__SOA_EACH_12(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_14(F, P, ...) F P CFLAT__SOA_EACH_13(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_15(F, P, ...) F P CFLAT__SOA_EACH_14(F, __VA_ARGS__)
+#define CFLAT__SOA_EACH_16(F, P, ...) F P CFLAT__SOA_EACH_15(F, __VA_ARGS__)
+
+#define CFLAT__SOA_COLUMN(T, NAME)     T *NAME;
+#define CFLAT__SOA_ROW(T, NAME)        T NAME;
+#define CFLAT__SOA_SIZE(T, NAME)       sizeof(T),
+#define CFLAT__SOA_POINTER(T, NAME)    (byte*)ss->NAME,
+#define CFLAT__SOA_ASSIGN(T, NAME)     ss->NAME = (T*)*column++;
+#define CFLAT__SOA_STORE(T, NAME)      ss->NAME[index] = row.NAME;
+#define CFLAT__SOA_LOAD(T, NAME)       .NAME = ss->NAME[index],
+
+// Declares the soa slice Name with a column per (type, name) pair, up to CFLAT_SOA_MAX_COLUMNS, and its row struct NameRow
+#define CFLAT_SOA_SLICE(NAME, ...)                                                                                               \
+    typedef struct NAME##Row { CFLAT__SOA_EACH(CFLAT__SOA_ROW, __VA_ARGS__) } NAME##Row;                                         \
+    typedef struct NAME { usize capacity; usize length; CFLAT__SOA_EACH(CFLAT__SOA_COLUMN, __VA_ARGS__) } NAME;                  \
+                                                                                                                                 \
+    static inline bool cflat__soa_##NAME##_reserve(CflatAllocator allocator, NAME *ss, usize capacity) {                         \
+        if (capacity <= ss->capacity) return true;                                                                               \
+        static const usize sizes[] = { CFLAT__SOA_EACH(CFLAT__SOA_SIZE, __VA_ARGS__) };                                          \
+        byte *columns[] = { CFLAT__SOA_EACH(CFLAT__SOA_POINTER, __VA_ARGS__) };                                                  \
+        if (!cflat__soa_slice_grow(allocator, columns, sizes, CFLAT_ARRAY_SIZE(sizes), ss->capacity, ss->length, capacity)) {    \
+            return false;                                                                                                        \
+        }                                                                                                                        \
+        byte **column = columns;                                                                                                 \
+        CFLAT__SOA_EACH(CFLAT__SOA_ASSIGN, __VA_ARGS__)                                                                          \
+        ss->capacity = capacity;                                                                                                 \
+        return true;                                                                                                             \
+    }                                                                                                                            \
+                                                                                                                                 \
+    static inline bool cflat__soa_##NAME##_append(CflatAllocator allocator, NAME *ss, NAME##Row row) {                           \
+        if (ss->length == ss->capacity                                                                                           \
+            && !cflat__soa_##NAME##_reserve(allocator, ss, cflat__slice_grown_capacity(ss->capacity, ss->length + 1))) {         \
+            return false;                                                                                                        \
+        }                                                                                                                        \
+        const usize index = ss->length++;                                                                                        \
+        CFLAT__SOA_EACH(CFLAT__SOA_STORE, __VA_ARGS__)                                                                           \
+        return true;                                                                                                             \
+    }                                                                                                                            \
+                                                                                                                                 \
+    static inline NAME##Row cflat__soa_##NAME##_get(const NAME *ss, usize index) {                                               \
+        return (NAME##Row){ CFLAT__SOA_EACH(CFLAT__SOA_LOAD, __VA_ARGS__) };                                                     \
+    }                                                                                                                            \
+                                                                                                                                 \
+    static inline void cflat__soa_##NAME##_set(NAME *ss, usize index, NAME##Row row) {                                           \
+        CFLAT__SOA_EACH(CFLAT__SOA_STORE, __VA_ARGS__)                                                                           \
+    }                                                                                                                            \
+                                                                                                                                 \
+    static inline void cflat__soa_##NAME##_delete(CflatAllocator allocator, NAME *ss) {                                          \
+        static const usize sizes[] = { CFLAT__SOA_EACH(CFLAT__SOA_SIZE, __VA_ARGS__) };                                          \
+        byte *columns[] = { CFLAT__SOA_EACH(CFLAT__SOA_POINTER, __VA_ARGS__) };                                                  \
+        cflat__soa_slice_free(allocator, columns[0], sizes, CFLAT_ARRAY_SIZE(sizes), ss->capacity);                              \
+        *ss = (NAME){0};                                                                                                         \
+    }                                                                                                                            \
+    typedef NAME NAME
+
+// Grows the slice so it can hold HINT rows, doubling its capacity at least
+#define cflat_soa_slice_resize(TSoa, ALLOCATOR, SS, HINT)                                                                        \
+    do {                                                                                                                         \
+        const usize cflat__hint = (HINT);                                                                                        \
+        if (cflat__hint > (SS)->capacity) {                                                                                      \
+            cflat__soa_##TSoa##_reserve(cflat_allocator(ALLOCATOR), (SS), cflat__slice_grown_capacity((SS)->capacity, cflat__hint)); \
+        }                                                                                                                        \
+    } while (0)
+
+#define cflat_soa_slice_reserve_exact(TSoa, ALLOCATOR, SS, CAPACITY) cflat__soa_##TSoa##_reserve(cflat_allocator(ALLOCATOR), (SS), (CAPACITY))
+
+// Appends a row, the arguments initialize a TSoaRow, evaluates to false if the allocator failed
+#define cflat_soa_slice_append(TSoa, ALLOCATOR, SS, ...)     cflat__soa_##TSoa##_append(cflat_allocator(ALLOCATOR), (SS), (TSoa##Row){ __VA_ARGS__ })
+
+#define cflat_soa_slice_get(TSoa, SS, INDEX)                 cflat__soa_##TSoa##_get((SS), cflat_bounds_check((INDEX), (SS)->length))
+#define cflat_soa_slice_set(TSoa, SS, INDEX, ...)            cflat__soa_##TSoa##_set((SS), cflat_bounds_check((INDEX), (SS)->length), (TSoa##Row){ __VA_ARGS__ })
+
+// Pointer to one field of a row
+#define cflat_soa_slice_at(SS, FIELD, INDEX)                 ( (SS).FIELD + cflat_bounds_check((INDEX), (SS).length) )
+
+#define cflat_soa_slice_delete(TSoa, ALLOCATOR, SS)          cflat__soa_##TSoa##_delete(cflat_allocator(ALLOCATOR), (SS))
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_SOA_SLICE_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_SOA_SLICE_H
+
+#if defined(CFLAT_SOA_SLICE_IMPLEMENTATION)
+
+// Where every column of a block of capacity rows starts, returns the size of the block
+static usize cflat__soa_slice_layout(const usize *sizes, usize count, usize capacity, usize *offsets) {
+    usize size = 0;
+    for (usize i = 0; i < count; ++i) {
+        offsets[i] = size;
+        size = cflat_align_pow2(size + capacity * sizes[i], CFLAT_SOA_COLUMN_ALIGN);
+    }
+    return size;
+}
+
+bool cflat__soa_slice_grow(CflatAllocator allocator, byte **columns, const usize *sizes, usize count, usize capacity, usize length, usize new_capacity) {
+    cflat_assert(count <= CFLAT_SOA_MAX_COLUMNS);
+    usize old_offsets[CFLAT_SOA_MAX_COLUMNS], new_offsets[CFLAT_SOA_MAX_COLUMNS];
+    const usize old_size = columns[0] ? cflat__soa_slice_layout(sizes, count, capacity, old_offsets) : 0;
+    const usize new_size = cflat__soa_slice_layout(sizes, count, new_capacity, new_offsets);
+
+    // An arena grows the block where it is when it's on top, the columns then only slide up inside it
+    byte *block = cflat_allocator_resize_opt(allocator, columns[0], old_size, new_size, (CflatAllocOpt){ .align = CFLAT_SOA_COLUMN_ALIGN });
+    if (block == NULL) return false;
+
+    // Last column first, every column moves up and would overwrite the start of the next one
+    for (usize i = count; i-- > 0;) {
+        if (old_size && length) cflat_mem_move(block + new_offsets[i], block + old_offsets[i], length * sizes[i]);
+        columns[i] = block + new_offsets[i];
+    }
+    return true;
+}
+
+void cflat__soa_slice_free(CflatAllocator allocator, byte *block, const usize *sizes, usize count, usize capacity) {
+    if (block == NULL) return;
+    usize offsets[CFLAT_SOA_MAX_COLUMNS];
+    cflat_allocator_free(allocator, block, cflat__soa_slice_layout(sizes, count, capacity, offsets));
+}
+
+#endif // CFLAT_SOA_SLICE_IMPLEMENTATION
+#undef CFLAT_SOA_SLICE_IMPLEMENTATION
+
+#if !defined(CFLAT_SOA_SLICE_NO_ALIAS)
+
+#   define SOA_SLICE CFLAT_SOA_SLICE
+#   define soa_slice_resize cflat_soa_slice_resize
+#   define soa_slice_reserve_exact cflat_soa_slice_reserve_exact
+#   define soa_slice_append cflat_soa_slice_append
+#   define soa_slice_get cflat_soa_slice_get
+#   define soa_slice_set cflat_soa_slice_set
+#   define soa_slice_at cflat_soa_slice_at
+#   define soa_slice_delete cflat_soa_slice_delete
+
+#endif // CFLAT_SOA_SLICE_NO_ALIAS
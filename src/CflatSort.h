@@ -0,0 +1,356 @@
+#ifndef CFLAT_SORT_H
+#define CFLAT_SORT_H
+
+#include "CflatCore.h"
+#include "CflatArena.h"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#endif
+
+/*
+ Sorting of plain keys in ascending order
+ Big inputs go through a least significant digit radix sort, 8 bits a pass, passes where every key has the same digit are skipped
+ Small inputs are cut into runs of 16 sorted by a sorting network, vectorized with AVX2 for 32 bit keys, and merged
+ The temporary buffer, as big as the input, is pushed on the scratch arena and popped before returning,
+ a NULL scratch arena uses one of the scratch arenas of the calling thread
+ Floats are ordered by their bits, -0.0 comes before 0.0 and NaNs go to the ends by their sign
+*/
+
+#if !defined(CFLAT_SORT_SMALL)
+#   define CFLAT_SORT_SMALL 64 // Inputs up to this many keys are merged from sorted runs instead of radix sorted
+#endif
+#define CFLAT_SORT_RUN 16
+
+/*
+@param scratch: arena the temporary buffer is pushed on, NULL for a scratch arena of the thread
+@param data:    keys to sort in place
+@param count:   number of keys
+*/
+CFLAT_DEF void cflat_sort_u32            (CflatArena *scratch, u32 *data, usize count                          );
+CFLAT_DEF void cflat_sort_u64            (CflatArena *scratch, u64 *data, usize count                          );
+CFLAT_DEF void cflat_sort_i32            (CflatArena *scratch, i32 *data, usize count                          );
+CFLAT_DEF void cflat_sort_f32            (CflatArena *scratch, f32 *data, usize count                          );
+
+/*
+Sorts the keys and moves every value along with its key, keys that compare equal keep their order
+@param scratch: arena the temporary buffers are pushed on, NULL for a scratch arena of the thread
+@param keys:    keys to sort in place
+@param values:  values to reorder in place
+@param count:   number of keys and values
+*/
+CFLAT_DEF void cflat_sort_kv_u32         (CflatArena *scratch, u32 *keys, u32 *values, usize count             );
+
+/*
+Reorders indices so keys[indices[0]], keys[indices[1]]... are ascending, the keys are left as they are
+Indices whose keys compare equal keep their order
+@param scratch: arena the temporary buffers are pushed on, NULL for a scratch arena of the thread
+@param indices: indices into keys to sort in place
+@param count:   number of indices
+@param keys:    keys the indices point at
+*/
+CFLAT_DEF void cflat_sort_indices_by_u32 (CflatArena *scratch, u32 *indices, usize count, const u32 *keys      );
+CFLAT_DEF void cflat_sort_indices_by_f32 (CflatArena *scratch, u32 *indices, usize count, const f32 *keys      );
+
+#define cflat_slice_sort_u32(SCRATCH, SLICE) cflat_sort_u32((SCRATCH), (SLICE).data, (SLICE).length)
+#define cflat_slice_sort_u64(SCRATCH, SLICE) cflat_sort_u64((SCRATCH), (SLICE).data, (SLICE).length)
+#define cflat_slice_sort_i32(SCRATCH, SLICE) cflat_sort_i32((SCRATCH), (SLICE).data, (SLICE).length)
+#define cflat_slice_sort_f32(SCRATCH, SLICE) cflat_sort_f32((SCRATCH), (SLICE).data, (SLICE).length)
+
+// Sorts KEYS carrying VALUES along, both slices have the length of KEYS
+#define cflat_slice_sort_kv_u32(SCRATCH, KEYS, VALUES)                                                                           \
+    cflat_sort_kv_u32((SCRATCH), (KEYS).data, (cflat_assert((VALUES).length == (KEYS).length), (VALUES).data), (KEYS).length)
+
+// Sorts the u32 slice INDICES by the elements of the slice KEYS they point at
+#define cflat_slice_sort_indices_by_u32(SCRATCH, INDICES, KEYS) cflat_sort_indices_by_u32((SCRATCH), (INDICES).data, (INDICES).length, (KEYS).data)
+#define cflat_slice_sort_indices_by_f32(SCRATCH, INDICES, KEYS) cflat_sort_indices_by_f32((SCRATCH), (INDICES).data, (INDICES).length, (KEYS).data)
+
+#if defined(CFLAT_IMPLEMENTATION)
+#define CFLAT_SORT_IMPLEMENTATION
+#endif
+
+#endif //CFLAT_SORT_H
+
+#if defined(CFLAT_SORT_IMPLEMENTATION)
+
+// Signed and float keys are sorted as u32 in place, through a type that may alias them
+typedef u32 cflat_may_alias cflat__sort_bits32;
+
+static inline u32 cflat__sort_f32_to_key(u32 bits) {
+    // Negative floats order backwards, flipping every bit of them and only the sign of the positive ones fixes both
+    return bits ^ ((u32)-(i32)(bits >> 31) | 0x80000000u);
+}
+
+static inline u32 cflat__sort_key_to_f32(u32 key) {
+    return key ^ ((u32)((i32)(key >> 31) - 1) | 0x80000000u);
+}
+
+static CflatTempArena cflat__sort_scratch_begin(CflatArena *scratch) {
+    return scratch ? cflat_arena_temp_begin(scratch) : cflat_get_scratch_arena();
+}
+
+// The thread's scratch arena goes back through cflat_drop_scratch_arena so it is trimmed after a large sort
+static void cflat__sort_scratch_end(CflatArena *scratch, CflatTempArena temp) {
+    if (scratch) cflat_arena_temp_end(temp);
+    else         cflat_drop_scratch_arena(temp);
+}
+
+// ---------------------------------------------------------------------------------------------------------------- Radix
+
+// One histogram per digit, taken in a single read of the keys
+// After an odd number of passes the keys are left in tmp, dst is the caller's buffer again and they are copied back
+#define CFLAT__RADIX_SORT(T, DIGITS, keys, tmp, values, tmp_values, count)                                                   \
+    do {                                                                                                                     \
+        usize counts[DIGITS][256] = {0};                                                                                     \
+        for (usize i = 0; i < (count); ++i) {                                                                                \
+            const T key = (keys)[i];                                                                                         \
+            for (usize d = 0; d < (DIGITS); ++d) counts[d][(key >> (d * 8)) & 0xFF] += 1;                                    \
+        }                                                                                                                    \
+        T   *src = (keys),   *dst = (tmp);                                                                                   \
+        u32 *src_v = (values), *dst_v = (tmp_values);                                                                        \
+        for (usize d = 0; d < (DIGITS); ++d) {                                                                               \
+            const usize shift = d * 8;                                                                                       \
+            usize *offsets = counts[d];                                                                                      \
+            if (offsets[(src[0] >> shift) & 0xFF] == (count)) continue;                                                      \
+            usize sum = 0;                                                                                                   \
+            for (usize b = 0; b < 256; ++b) {                                                                                \
+                const usize n = offsets[b];                                                                                  \
+                offsets[b] = sum;                                                                                            \
+                sum += n;                                                                                                    \
+            }                                                                                                                \
+            if (src_v) {                                                                                                     \
+                for (usize i = 0; i < (count); ++i) {                                                                        \
+                    const usize at = offsets[(src[i] >> shift) & 0xFF]++;                                                    \
+                    dst[at]   = src[i];                                                                                      \
+                    dst_v[at] = src_v[i];                                                                                    \
+                }                                                                                                            \
+                cflat_swap(u32*, src_v, dst_v);                                                                              \
+            } else {                                                                                                         \
+                for (usize i = 0; i < (count); ++i) dst[offsets[(src[i] >> shift) & 0xFF]++] = src[i];                       \
+            }                                                                                                                \
+            cflat_swap(T*, src, dst);                                                                                        \
+        }                                                                                                                    \
+        if (src != (keys)) {                                                                                                 \
+            cflat_mem_copy(dst, src, (count) * sizeof(T));                                                                   \
+            if (src_v) cflat_mem_copy(dst_v, src_v, (count) * sizeof(u32));                                                  \
+        }                                                                                                                    \
+    } while (0)
+
+static void cflat__radix_sort_u32(u32 *keys, u32 *tmp, u32 *values, u32 *tmp_values, usize count) {
+    CFLAT__RADIX_SORT(u32, 4, keys, tmp, values, tmp_values, count);
+}
+
+static void cflat__radix_sort_u64(u64 *keys, u64 *tmp, usize count) {
+    CFLAT__RADIX_SORT(u64, 8, keys, tmp, (u32*)NULL, (u32*)NULL, count);
+}
+
+#undef CFLAT__RADIX_SORT
+
+// ---------------------------------------------------------------------------------------------------------------- Runs
+
+#if defined(__AVX2__)
+
+// Lane i of V meets lane PERM[i], the lanes in MASK keep the bigger key
+#define CFLAT__SORT_EXCHANGE(V, MASK, ...)                                                                                   \
+    do {                                                                                                                     \
+        const __m256i cflat__p = _mm256_permutevar8x32_epi32((V), _mm256_setr_epi32(__VA_ARGS__));                           \
+        (V) = _mm256_blend_epi32(_mm256_min_epu32((V), cflat__p), _mm256_max_epu32((V), cflat__p), (MASK));                  \
+    } while (0)
+
+// The 19 comparator network of depth 6 for 8 keys
+static inline __m256i cflat__sort_network8(__m256i v) {
+    CFLAT__SORT_EXCHANGE(v, 0xCC, 2, 3, 0, 1, 6, 7, 4, 5);
+    CFLAT__SORT_EXCHANGE(v, 0xF0, 4, 5, 6, 7, 0, 1, 2, 3);
+    CFLAT__SORT_EXCHANGE(v, 0xAA, 1, 0, 3, 2, 5, 4, 7, 6);
+    CFLAT__SORT_EXCHANGE(v, 0x30, 0, 1, 4, 5, 2, 3, 6, 7);
+    CFLAT__SORT_EXCHANGE(v, 0x50, 0, 4, 2, 6, 1, 5, 3, 7);
+    CFLAT__SORT_EXCHANGE(v, 0x54, 0, 2, 1, 4, 3, 6, 5, 7);
+    return v;
+}
+
+// Sorts 8 keys that rise then fall
+static inline __m256i cflat__sort_bitonic8(__m256i v) {
+    CFLAT__SORT_EXCHANGE(v, 0xF0, 4, 5, 6, 7, 0, 1, 2, 3);
+    CFLAT__SORT_EXCHANGE(v, 0xCC, 2, 3, 0, 1, 6, 7, 4, 5);
+    CFLAT__SORT_EXCHANGE(v, 0xAA, 1, 0, 3, 2, 5, 4, 7, 6);
+    return v;
+}
+
+#undef CFLAT__SORT_EXCHANGE
+
+// Sorts a run of up to CFLAT_SORT_RUN keys, the missing ones are padded with the biggest key
+static void cflat__sort_run_u32(u32 *keys, usize count) {
+    cflat_alignas(32) u32 run[CFLAT_SORT_RUN];
+    for (usize i = 0; i < CFLAT_SORT_RUN; ++i) run[i] = i < count ? keys[i] : UINT32_MAX;
+    __m256i lo = cflat__sort_network8(_mm256_load_si256((const __m256i*)&run[0]));
+    __m256i hi = cflat__sort_network8(_mm256_load_si256((const __m256i*)&run[8]));
+    hi = _mm256_permutevar8x32_epi32(hi, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    const __m256i min = _mm256_min_epu32(lo, hi);
+    const __m256i max = _mm256_max_epu32(lo, hi);
+    _mm256_store_si256((__m256i*)&run[0], cflat__sort_bitonic8(min));
+    _mm256_store_si256((__m256i*)&run[8], cflat__sort_bitonic8(max));
+    cflat_mem_copy(keys, run, count * sizeof(u32));
+}
+
+#else
+
+static void cflat__sort_run_u32(u32 *keys, usize count) {
+    for (usize i = 1; i < count; ++i) {
+        const u32 key = keys[i];
+        usize j = i;
+        for (; j > 0 && keys[j - 1] > key; --j) keys[j] = keys[j - 1];
+        keys[j] = key;
+    }
+}
+
+#endif // __AVX2__
+
+static void cflat__sort_run_u64(u64 *keys, usize count) {
+    for (usize i = 1; i < count; ++i) {
+        const u64 key = keys[i];
+        usize j = i;
+        for (; j > 0 && keys[j - 1] > key; --j) keys[j] = keys[j - 1];
+        keys[j] = key;
+    }
+}
+
+// Sorts runs of CFLAT_SORT_RUN keys and merges them pairwise, ping ponging between keys and tmp
+#define CFLAT__MERGE_SORT(T, RUN_SORT, keys, tmp, count)                                                                     \
+    do {                                                                                                                     \
+        for (usize at = 0; at < (count); at += CFLAT_SORT_RUN) {                                                             \
+            RUN_SORT((keys) + at, cflat_min((usize)CFLAT_SORT_RUN, (count) - at));                                           \
+        }                                                                                                                    \
+        T *src = (keys), *dst = (tmp);                                                                                       \
+        for (usize width = CFLAT_SORT_RUN; width < (count); width *= 2) {                                                    \
+            for (usize at = 0; at < (count); at += 2 * width) {                                                              \
+                const usize mid = cflat_min(at + width, (count));                                                            \
+                const usize end = cflat_min(at + 2 * width, (count));                                                        \
+                usize l = at, r = mid, o = at;                                                                               \
+                while (l < mid && r < end) dst[o++] = src[r] < src[l] ? src[r++] : src[l++];                                 \
+                while (l < mid) dst[o++] = src[l++];                                                                         \
+                while (r < end) dst[o++] = src[r++];                                                                         \
+            }                                                                                                                \
+            cflat_swap(T*, src, dst);                                                                                        \
+        }                                                                                                                    \
+        if (src != (keys)) cflat_mem_copy((keys), src, (count) * sizeof(T));                                                 \
+    } while (0)
+
+static void cflat__sort_u32(CflatArena *scratch, u32 *keys, usize count) {
+    if (count <= 1) return;
+    if (count <= CFLAT_SORT_RUN) {
+        cflat__sort_run_u32(keys, count);
+        return;
+    }
+    CflatTempArena temp = cflat__sort_scratch_begin(scratch);
+    u32 *tmp = cflat_arena_push_array(u32, temp.arena, count);
+    if (count <= CFLAT_SORT_SMALL) {
+        CFLAT__MERGE_SORT(u32, cflat__sort_run_u32, keys, tmp, count);
+    } else {
+        cflat__radix_sort_u32(keys, tmp, NULL, NULL, count);
+    }
+    cflat__sort_scratch_end(scratch, temp);
+}
+
+// ---------------------------------------------------------------------------------------------------------------- Api
+
+void cflat_sort_u32(CflatArena *scratch, u32 *data, usize count) {
+    cflat__sort_u32(scratch, data, count);
+}
+
+void cflat_sort_u64(CflatArena *scratch, u64 *data, usize count) {
+    if (count <= 1) return;
+    if (count <= CFLAT_SORT_RUN) {
+        cflat__sort_run_u64(data, count);
+        return;
+    }
+    CflatTempArena temp = cflat__sort_scratch_begin(scratch);
+    u64 *tmp = cflat_arena_push_array(u64, temp.arena, count);
+    if (count <= CFLAT_SORT_SMALL) {
+        CFLAT__MERGE_SORT(u64, cflat__sort_run_u64, data, tmp, count);
+    } else {
+        cflat__radix_sort_u64(data, tmp, count);
+    }
+    cflat__sort_scratch_end(scratch, temp);
+}
+
+#undef CFLAT__MERGE_SORT
+
+void cflat_sort_i32(CflatArena *scratch, i32 *data, usize count) {
+    cflat__sort_bits32 *keys = (cflat__sort_bits32*)data;
+    for (usize i = 0; i < count; ++i) keys[i] ^= 0x80000000u;
+    cflat__sort_u32(scratch, (u32*)keys, count);
+    for (usize i = 0; i < count; ++i) keys[i] ^= 0x80000000u;
+}
+
+void cflat_sort_f32(CflatArena *scratch, f32 *data, usize count) {
+    cflat__sort_bits32 *keys = (cflat__sort_bits32*)data;
+    for (usize i = 0; i < count; ++i) keys[i] = cflat__sort_f32_to_key(keys[i]);
+    cflat__sort_u32(scratch, (u32*)keys, count);
+    for (usize i = 0; i < count; ++i) keys[i] = cflat__sort_key_to_f32(keys[i]);
+}
+
+// Radix sort is stable, small inputs use insertion sort which is too
+static void cflat__sort_kv_u32(CflatArena *scratch, u32 *keys, u32 *values, usize count) {
+    if (count <= 1) return;
+    if (count <= CFLAT_SORT_RUN) {
+        for (usize i = 1; i < count; ++i) {
+            const u32 key = keys[i], value = values[i];
+            usize j = i;
+            for (; j > 0 && keys[j - 1] > key; --j) {
+                keys[j]   = keys[j - 1];
+                values[j] = values[j - 1];
+            }
+            keys[j]   = key;
+            values[j] = value;
+        }
+        return;
+    }
+    CflatTempArena temp = cflat__sort_scratch_begin(scratch);
+    u32 *tmp        = cflat_arena_push_array(u32, temp.arena, count);
+    u32 *tmp_values = cflat_arena_push_array(u32, temp.arena, count);
+    cflat__radix_sort_u32(keys, tmp, values, tmp_values, count);
+    cflat__sort_scratch_end(scratch, temp);
+}
+
+void cflat_sort_kv_u32(CflatArena *scratch, u32 *keys, u32 *values, usize count) {
+    cflat__sort_kv_u32(scratch, keys, values, count);
+}
+
+void cflat_sort_indices_by_u32(CflatArena *scratch, u32 *indices, usize count, const u32 *keys) {
+    CflatTempArena temp = cflat__sort_scratch_begin(scratch);
+    u32 *gathered = cflat_arena_push_array(u32, temp.arena, count);
+    for (usize i = 0; i < count; ++i) gathered[i] = keys[indices[i]];
+    cflat__sort_kv_u32(temp.arena, gathered, indices, count);
+    cflat__sort_scratch_end(scratch, temp);
+}
+
+void cflat_sort_indices_by_f32(CflatArena *scratch, u32 *indices, usize count, const f32 *keys) {
+    const cflat__sort_bits32 *bits = (const cflat__sort_bits32*)keys;
+    CflatTempArena temp = cflat__sort_scratch_begin(scratch);
+    u32 *gathered = cflat_arena_push_array(u32, temp.arena, count);
+    for (usize i = 0; i < count; ++i) gathered[i] = cflat__sort_f32_to_key(bits[indices[i]]);
+    cflat__sort_kv_u32(temp.arena, gathered, indices, count);
+    cflat__sort_scratch_end(scratch, temp);
+}
+
+#endif // CFLAT_SORT_IMPLEMENTATION
+#undef CFLAT_SORT_IMPLEMENTATION
+
+#if !defined(CFLAT_SORT_NO_ALIAS)
+
+#   define sort_u32 cflat_sort_u32
+#   define sort_u64 cflat_sort_u64
+#   define sort_i32 cflat_sort_i32
+#   define sort_f32 cflat_sort_f32
+#   define sort_kv_u32 cflat_sort_kv_u32
+#   define sort_indices_by_u32 cflat_sort_indices_by_u32
+#   define sort_indices_by_f32 cflat_sort_indices_by_f32
+#   define slice_sort_u32 cflat_slice_sort_u32
+#   define slice_sort_u64 cflat_slice_sort_u64
+#   define slice_sort_i32 cflat_slice_sort_i32
+#   define slice_sort_f32 cflat_slice_sort_f32
+#   define slice_sort_kv_u32 cflat_slice_sort_kv_u32
+#   define slice_sort_indices_by_u32 cflat_slice_sort_indices_by_u32
+#   define slice_sort_indices_by_f32 cflat_slice_sort_indices_by_f32
+
+#endif // CFLAT_SORT_NO_ALIAS
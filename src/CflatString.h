@@ -2,6 +2,7 @@
 #define CFLAT_CFLAT_STRING_H
 
 #include "CflatArena.h"
+#include "CflatAllocator.h"
 #include "CflatCore.h"
 #include "CflatAppend.h"
 #include "CflatSlice.h"
@@ -15,8 +16,8 @@ typedef struct cflat_string_view {
 } CflatStringView;
 
 CFLAT_DEF CflatStringView cflat_sv_from_cstr           (const char *cstr                                                   );
-CFLAT_DEF CflatStringView cflat_sv_clone_cstr          (CflatArena *a, const char *cstr                                    );
-CFLAT_DEF CflatStringView cflat_sv_clone_sv            (CflatArena *a, CflatStringView sv                                  );
+CFLAT_DEF CflatStringView (cflat_sv_clone_cstr)        (CflatAllocator a, const char *cstr                                 );
+CFLAT_DEF CflatStringView (cflat_sv_clone_sv)          (CflatAllocator a, CflatStringView sv                               );
 CFLAT_DEF CflatStringView cflat_sv_find_substring_cstr (CflatStringView strnig, const char         *substring              );
 CFLAT_DEF CflatStringView cflat_sv_find_substring_sv   (CflatStringView strnig, CflatStringView     substring              );
 CFLAT_DEF isize           cflat_sv_find_index_cstr     (CflatStringView strnig, const char *substring                      );
@@ -25,7 +26,7 @@ CFLAT_DEF isize           cflat_sv_find_last_index_cstr(CflatStringView strnig,
 CFLAT_DEF isize           cflat_sv_find_last_index_sv  (CflatStringView strnig, CflatStringView substring                  );
 CFLAT_DEF CflatStringView cflat_path_name_cstr         (const char *path                                                   );
 CFLAT_DEF CflatStringView cflat_path_name_sv           (CflatStringView path                                               );
-CFLAT_DEF CflatStringView cflat_sv_printf              (CflatArena *a, const char *fmt, ...                                );
+CFLAT_DEF CflatStringView (cflat_sv_printf)            (CflatAllocator a, const char *fmt, ...                             );
 
 #define CFLAT__STRING_OVERLOAD(STR, func) _Generic((STR)                            \
     , char*:                        func##_cstr                                     \
@@ -34,7 +35,11 @@ CFLAT_DEF CflatStringView cflat_sv_printf              (CflatArena *a, const cha
 )
 
 #define cflat_sv_lit(STR)                             (CflatStringView) { .data = (STR), .length = sizeof(STR) - 1, .capacity = sizeof(STR) }
-#define cflat_sv_clone(ARENA, STR)                    CFLAT__STRING_OVERLOAD((STR), cflat_sv_clone)((ARENA), (STR))
+#define cflat_sv_clone(ALLOCATOR, STR)                CFLAT__STRING_OVERLOAD((STR), cflat_sv_clone)(cflat_allocator(ALLOCATOR), (STR))
+#define cflat_sv_clone_cstr(ALLOCATOR, CSTR)          (cflat_sv_clone_cstr)(cflat_allocator(ALLOCATOR), (CSTR))
+#define cflat_sv_clone_sv(ALLOCATOR, SV)              (cflat_sv_clone_sv)(cflat_allocator(ALLOCATOR), (SV))
+#define cflat_sv_printf(ALLOCATOR, ...)               (cflat_sv_printf)(cflat_allocator(ALLOCATOR), __VA_ARGS__)
+#define cflat_sv_delete(ALLOCATOR, SV)                cflat_allocator_free(cflat_allocator(ALLOCATOR), (SV).data, (SV).capacity)
 #define cflat_sv_find_substring(strnig, substring)    CFLAT__STRING_OVERLOAD((substring), cflat_sv_find_substring)((strnig), (substring))
 #define cflat_sv_find_index(strnig, substring)        CFLAT__STRING_OVERLOAD((substring), cflat_sv_find_index)((strnig), (substring))
 #define cflat_sv_find_last_index(strnig, substring)   CFLAT__STRING_OVERLOAD((substring), cflat_sv_find_last_index)((strnig), (substring))
@@ -49,11 +54,12 @@ typedef struct cflat_dfa_kmp {
 
 #define cflat_dfa_at(DFA, ROW, COL) (DFA)->transitions[((ROW) * (DFA)->columns + (COL)) * sizeof *(DFA)->transitions]
 
-CFLAT_DEF CflatDfaKmp* cflat_dfa_kmp_new   (CflatArena *a, usize rows, usize columns);
+CFLAT_DEF CflatDfaKmp* (cflat_dfa_kmp_new) (CflatAllocator a, usize rows, usize columns);
 CFLAT_DEF CflatDfaKmp* cflat_dfa_match_sv  (CflatDfaKmp *dfa, CflatStringView pattern);
 CflatDfaKmp* clfat_dfa_match_cstr(CflatDfaKmp *dfa, const char *str);
 CFLAT_DEF isize        cflat_dfa_run_sv    (CflatDfaKmp *dfa, CflatStringView input);
 CFLAT_DEF isize        cflat_dfa_run_cstr  (CflatDfaKmp *dfa, const char *str);
+#define cflat_dfa_kmp_new(ALLOCATOR, ROWS, COLUMNS)   (cflat_dfa_kmp_new)(cflat_allocator(ALLOCATOR), (ROWS), (COLUMNS))
 #define cflat_dfa_kmp_match(DFA, PATTERN)     CFLAT__STRING_OVERLOAD((PATTERN), cflat_dfa_kmp_match)((DFA), (PATTERN))
 #define cflat_dfa_kmp_run(DFA, PATTERN)       CFLAT__STRING_OVERLOAD((PATTERN), cflat_dfa_kmp_run)((DFA), (PATTERN))
 
@@ -85,11 +91,11 @@ CflatStringView cflat_sv_from_cstr(const char *cstr)  {
     };
  }
 
-CflatStringView cflat_sv_clone_cstr(CflatArena *a, const char *cstr) {
+CflatStringView (cflat_sv_clone_cstr)(CflatAllocator a, const char *cstr) {
     const usize len = strlen(cstr);
     const usize cap = len + 1;
     CflatStringView result = (CflatStringView) {
-        .data = arena_push(a, cap, .align = cflat_alignof(char), .clear = false),
+        .data = cflat_allocator_alloc(a, cap, .align = cflat_alignof(char), .clear = false),
         .length = len,
         .capacity = cap,
     };
@@ -98,10 +104,10 @@ CflatStringView cflat_sv_clone_cstr(CflatArena *a, const char *cstr) {
     return result;
 }
 
-CflatStringView cflat_sv_clone_sv(CflatArena *a, CflatStringView sv) {
+CflatStringView (cflat_sv_clone_sv)(CflatAllocator a, CflatStringView sv) {
     const usize cap = sv.length + 1;
     CflatStringView result = (CflatStringView) {
-        .data = arena_push(a, sizeof(char)*cap, .align = cflat_alignof(char), .clear = false),
+        .data = cflat_allocator_alloc(a, sizeof(char)*cap, .align = cflat_alignof(char), .clear = false),
         .length = sv.length,
         .capacity = cap,
     };
@@ -110,8 +116,8 @@ CflatStringView cflat_sv_clone_sv(CflatArena *a, CflatStringView sv) {
     return result;
 }
 
-CflatDfaKmp* cflat_dfa_kmp_new(CflatArena *a, usize rows, usize columns) {
-    CflatDfaKmp *dfa = arena_push(a, sizeof *dfa + sizeof *dfa->transitions*rows*columns, 0);
+CflatDfaKmp* (cflat_dfa_kmp_new)(CflatAllocator a, usize rows, usize columns) {
+    CflatDfaKmp *dfa = cflat_allocator_alloc(a, sizeof *dfa + sizeof *dfa->transitions*rows*columns, 0);
     dfa->rows     = rows;
     dfa->columns  = columns;
     return dfa;
@@ -131,9 +137,9 @@ CflatDfaKmp* cflat_dfa_kmp_match_sv(CflatDfaKmp *dfa, CflatStringView pattern) {
             cflat_dfa_at(dfa, q, i) = cflat_dfa_at(dfa, state, i);
         }
         
-        if (q < pattern.length) 
-            cflat_dfa_at(dfa, q, (u8)pattern.data[q]) = q + 1;
-        
+        if (q == pattern.length) break;
+
+        cflat_dfa_at(dfa, q, (u8)pattern.data[q]) = q + 1;
         state = cflat_dfa_at(dfa, state, (u8)pattern.data[q]);
     }
     
@@ -238,7 +244,7 @@ CflatStringView cflat_path_name_sv(CflatStringView path) {
 
 CflatStringView cflat_path_name_cstr(const char *path) { return cflat_path_name_sv(cflat_sv_from_cstr(path)); }
 
-CflatStringView cflat_sv_printf(CflatArena *a, const char *fmt, ...) {
+CflatStringView (cflat_sv_printf)(CflatAllocator a, const char *fmt, ...) {
     va_list args, args_copy;
     va_start(args, fmt);
     va_copy(args_copy, args);
@@ -247,7 +253,7 @@ CflatStringView cflat_sv_printf(CflatArena *a, const char *fmt, ...) {
     DIAGNOSTIC_POP();
     va_end(args);
     CflatStringView result = (CflatStringView) {
-        .data = arena_push(a, required_length, .align = cflat_alignof(char), .clear = false),
+        .data = cflat_allocator_alloc(a, required_length, .align = cflat_alignof(char), .clear = false),
         .length = required_length - 1,
         .capacity = required_length,
     };
@@ -275,6 +281,7 @@ CflatStringView cflat_sv_printf(CflatArena *a, const char *fmt, ...) {
 #   define String CflatString
 #   define StringView CflatStringView
 #   define sv_printf cflat_sv_printf
+#   define sv_delete cflat_sv_delete
 #   define dfa_at cflat_dfa_at
 #   define dfa_kmp_match cflat_dfa_kmp_match
 #   define dfa_kmp_match_cstr cflat_dfa_kmp_match_cstr
@@ -0,0 +1,60 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang arena_bench.c -O2 -o arena_bench.script
+./arena_bench.script
+rm ./arena_bench.script
+exit 0
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/CflatArena.h"
+#include "bench.h"
+
+#define CYCLES 200
+
+static u64 rng_state = 0x9E3779B97F4A7C15ull;
+
+static u64 rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Every push overflows the current node, so each one after the first cycle is served from the free nodes
+static void bench_clear_refill(usize node_count) {
+    usize *sizes = malloc(node_count * sizeof(*sizes));
+    for (usize i = 0; i < node_count; ++i) {
+        sizes[i] = KiB(4) + (rng_next() % KiB(252));
+    }
+
+    Arena *arena = arena_new(.reserve = KiB(4), .growth = CFLAT_ARENA_GROW_EXACT);
+    for (usize i = 0; i < node_count; ++i) arena_push(arena, sizes[i], .align = 1);
+
+    const double begin = bench_now_ns();
+    for (usize cycle = 0; cycle < CYCLES; ++cycle) {
+        arena_clear(arena);
+        for (usize i = 0; i < node_count; ++i) {
+            BENCH_KEEP(arena_push(arena, sizes[(i + cycle) % node_count], .align = 1));
+        }
+    }
+    const double elapsed = bench_now_ns() - begin;
+
+    char name[64];
+    snprintf(name, sizeof name, "clear/refill %5zu mixed nodes", node_count);
+    bench_report(name, elapsed, CYCLES * node_count);
+
+    arena_delete(arena);
+    free(sizes);
+}
+
+int main(void) {
+    const usize node_counts[] = { 16, 128, 1024, 4096 };
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(node_counts); ++i) {
+        bench_clear_refill(node_counts[i]);
+    }
+    return 0;
+}
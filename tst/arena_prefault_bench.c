@@ -0,0 +1,55 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang arena_prefault_bench.c -O2 -o arena_prefault_bench.script
+./arena_prefault_bench.script
+rm ./arena_prefault_bench.script
+exit 0
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/CflatArena.h"
+#include "bench.h"
+
+#define PUSHES    (1 << 16)
+#define PUSH_SIZE 512
+#define ROUNDS    8
+
+static double samples[PUSHES];
+
+// Times push + first write of each block on a fresh arena, the arena commits ahead of the pushes so
+// without prefaulting every page boundary crossed pays for a page fault inside the timed region
+static void bench_push_latency(const char *name, bool prefault) {
+    static double p50[ROUNDS], p99[ROUNDS], p999[ROUNDS];
+    double total = 0;
+
+    for (usize round = 0; round < ROUNDS; ++round) {
+        Arena *arena = arena_new(.reserve = (usize)PUSHES * PUSH_SIZE * 2, .commit = MiB(1), .prefault = prefault);
+        for (usize i = 0; i < PUSHES; ++i) {
+            const double begin = bench_now_ns();
+            byte *mem = arena_push(arena, PUSH_SIZE, .align = 1);
+            memset(mem, (int)i, PUSH_SIZE);
+            samples[i] = bench_now_ns() - begin;
+            total += samples[i];
+        }
+        arena_delete(arena);
+
+        p999[round] = bench_percentile(samples, PUSHES, 99.9);
+        p99[round]  = bench_percentile(samples, PUSHES, 99.0);
+        p50[round]  = bench_percentile(samples, PUSHES, 50.0);
+    }
+
+    // The median round keeps a stray preemption from deciding the result
+    printf("%-28s p50 %8.1f ns  p99 %8.1f ns  p99.9 %8.1f ns  mean %8.1f ns\n", name,
+        bench_percentile(p50, ROUNDS, 50.0), bench_percentile(p99, ROUNDS, 50.0),
+        bench_percentile(p999, ROUNDS, 50.0), total / (double)(ROUNDS * PUSHES));
+}
+
+int main(void) {
+    bench_push_latency("push+touch lazy commit", false);
+    bench_push_latency("push+touch prefault", true);
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <winnt.h>
 #define DEBUG 1
+#define CFLAT_ARENA_STATS 1
 
 #if !defined(CFLAT_IMPLEMENTATION)
 #   define CFLAT_IMPLEMENTATION
@@ -11,12 +12,33 @@
 
 #define CFLAT_DEF static inline
 #include "../src/Cflat.h"
+#include "../src/CflatPool.h"
+#include "../src/CflatSlab.h"
+#include "../src/CflatChannel.h"
+#include "../src/CflatFrameArena.h"
+#include "../src/CflatFileView.h"
+#include "../src/CflatSegmentedSlice.h"
+#include "../src/CflatSoaSlice.h"
+#include "../src/CflatAVX.h"
+#include "../src/CflatSort.h"
 #include "unitest.h"
+#if defined(OS_UNIX)
+#include <pthread.h>
+#include <sys/wait.h>
+#endif
 
 typedef struct {
     CFLAT_SLICE_FIELDS(i32);
 } i32Slice;
 
+typedef struct {
+    CFLAT_SLICE_FIELDS(u32);
+} u32Slice;
+
+typedef struct {
+    CFLAT_SLICE_FIELDS(f32);
+} f32Slice;
+
 Arena *a;
 
 void arena_push_should_create_new_block(void) {
@@ -28,8 +50,10 @@ void arena_push_should_create_new_block(void) {
     // Assert
     ASSERT_NOT_EQUAL((void*)prev, (void*)a->curr, "%p");
     ASSERT_NOT_NULL((void*)
-        ((uptr)a->curr | (uptr)a->free)
+        ((uptr)a->curr | (uptr)a->free_mask)
     );
+    // Only the first node holds the arena, the others start right after their own header
+    ASSERT_EQUAL(a->curr->pos, sizeof(CflatArenaNode) + cap, "%zu");
 }
 
 void arena_clear_should_clear(void) {
@@ -59,7 +83,8 @@ void alloc_should_reset_len_when_taking_from_free_list(void) {
     a->curr->pos += 1;
     arena_clear(a);
     // Assert
-    ASSERT_EQUAL(a->curr->pos, sizeof(struct cflat_arena_node), "%zu");
+    // The first node holds the arena itself
+    ASSERT_EQUAL(a->curr->pos, a->curr == &a->_node ? sizeof(CflatArena) : sizeof(CflatArenaNode), "%zu");
 }
 
 void free_list_does_not_have_sufficiently_large_block(void) {
@@ -72,7 +97,9 @@ void free_list_does_not_have_sufficiently_large_block(void) {
     arena_push(a, double_cap, 1, true);
     // Assert
     ASSERT_GREATER_OR_EQUAL(a->curr->res, double_cap, "%zu");
-    ASSERT_LESS_OR_EQUAL(a->free->res, double_cap, "%zu");
+    arena_for_each_free_node(a, node) {
+        ASSERT_LESS_OR_EQUAL(node->res, double_cap, "%zu");
+    }
 }
 
 void dealloc_should_offset_len(void) {
@@ -89,19 +116,19 @@ void pop_should_free_blocks(void) {
     // Arrange
     usize freelist_count = 0;
     usize max_res = a->curr->res;
-    for (const CflatArenaNode *curr = a->free; curr; curr = curr->prev) {
+    arena_for_each_free_node(a, node) {
         freelist_count += 1;
-        max_res = max(max_res, curr->res);
+        max_res = max(max_res, node->res);
     }
     // Act
     arena_push(a, max_res, 1, true);
     arena_pop(a, max_res);
     usize new_freelist_count = 0;
-    for (const CflatArenaNode *curr = a->free; curr; curr = curr->prev) {
+    arena_for_each_free_node(a, node) {
         new_freelist_count += 1;
     }
     // Assert
-    ASSERT_NOT_NULL(a->free);
+    ASSERT_NOT_EQUAL((usize)a->free_mask, (usize)0, "%zu");
     ASSERT_GREATER_THAN(new_freelist_count, freelist_count, "%zu");
 }
 
@@ -140,6 +167,871 @@ void subslice_should_work(void) {
     ASSERT_EQUAL(slice_data(sub)[1], 3, "%d");
 }
 
+void arena_huge_pages_should_report_page_size(void) {
+    // Arrange
+    Arena *huge = arena_new(.reserve = MiB(8), .commit = KiB(4), .page_size = MiB(2));
+    const usize page_size = arena_page_size(huge);
+    // Act
+    byte *mem = arena_push(huge, MiB(3), .clear = true);
+    mem[MiB(3) - 1] = 1;
+    // Assert
+    ASSERT_TRUE(page_size == MiB(2) || page_size == cflat__os_page_size());
+    ASSERT_TRUE(page_size == MiB(2) || !cflat_has_flag(huge->flags, CFLAT_ARENA_HUGE_PAGES | CFLAT_ARENA_TRANSPARENT_HUGE_PAGES));
+    ASSERT_EQUAL((uptr)huge->curr % page_size, (uptr)0, "%zu");
+    ASSERT_EQUAL(huge->curr->cmt % page_size, (usize)0, "%zu");
+    arena_delete(huge);
+}
+
+void arena_clear_should_decommit_above_keep_warm(void) {
+    // Arrange
+    Arena *warm = arena_new(.reserve = MiB(1), .keep_warm = KiB(64), .hysteresis = KiB(64));
+    for (usize i = 0; i < 64; ++i) {
+        byte *mem = arena_push(warm, KiB(64), .clear = true);
+        mem[KiB(64) - 1] = 1;
+    }
+    ASSERT_GREATER_THAN(warm->committed, (usize)MiB(4), "%zu");
+    // Act
+    arena_clear(warm);
+    // Assert
+    ASSERT_LESS_OR_EQUAL(warm->committed, (usize)KiB(64) + KiB(64), "%zu");
+    byte *mem = arena_push(warm, MiB(2), .clear = true);
+    ASSERT_EQUAL(mem[MiB(2) - 1], 0, "%d");
+    arena_delete(warm);
+}
+
+void arena_push_clear_should_zero_recycled_memory(void) {
+    // Arrange
+    const usize base = a->curr->pos;
+    byte *dirty = arena_push(a, 128, .align = 1);
+    memset(dirty, 0xFF, 128);
+    arena_pop(a, 128);
+    // Act
+    byte *mem = arena_push(a, 256, .align = 1, .clear = true);
+    // Assert
+    ASSERT_EQUAL((void*)mem, (void*)((byte*)a->curr + base), "%p");
+    for (usize i = 0; i < 256; ++i) ASSERT_EQUAL(mem[i], 0, "%d");
+    ASSERT_GREATER_OR_EQUAL(a->curr->dirty, a->curr->pos, "%zu");
+}
+
+void arena_growth_should_keep_node_count_logarithmic(void) {
+    // Arrange
+    Arena *growing = arena_new(.reserve = KiB(64));
+    const usize total = MiB(64);
+    // Act
+    for (usize i = 0; i < total / KiB(1); ++i) {
+        arena_push(growing, KiB(1), .align = 1);
+    }
+    usize node_count = 0;
+    for (const CflatArenaNode *node = growing->curr; node; node = node->prev) node_count += 1;
+    // Assert
+    ASSERT_LESS_OR_EQUAL(node_count, (usize)12, "%zu");
+    arena_delete(growing);
+}
+
+void free_list_should_pick_best_fit(void) {
+    // Arrange
+    Arena *mixed = arena_new(.reserve = KiB(64), .growth = CFLAT_ARENA_GROW_EXACT);
+    const usize sizes[] = { KiB(300), KiB(40), KiB(600), KiB(100), KiB(70) };
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(sizes); ++i) {
+        arena_push(mixed, sizes[i], .align = 1);
+    }
+    arena_clear(mixed);
+    arena_push(mixed, KiB(60), .align = 1);
+    // Act
+    arena_push(mixed, KiB(90), .align = 1);
+    // Assert
+    ASSERT_GREATER_OR_EQUAL(mixed->curr->res, (usize)KiB(90), "%zu");
+    ASSERT_LESS_THAN(mixed->curr->res, (usize)KiB(300), "%zu");
+    arena_delete(mixed);
+}
+
+void arena_stats_should_count_padding_and_extends(void) {
+    // Arrange
+    Arena *counted = arena_new(.reserve = KiB(64), .commit = KiB(4));
+    // Act
+    arena_push(counted, 1, .align = 1);
+    arena_push(counted, 8, .align = 8);
+    u8 *grown = arena_push(counted, 16, .align = 1);
+    grown = arena_extend(counted, grown, 16, 32);
+    arena_push(counted, 1, .align = 1);
+    arena_extend(counted, grown, 32, 64);
+    arena_push(counted, KiB(128), .align = 1);
+    ArenaStats stats = arena_stats(counted);
+    // Assert
+    ASSERT_EQUAL(stats.requested, (usize)(1 + 8 + 16 + 16 + 1 + 64 + KiB(128)), "%zu");
+    ASSERT_EQUAL(stats.consumed - stats.requested, (usize)14, "%zu");
+    ASSERT_EQUAL(stats.extend_in_place, (usize)1, "%zu");
+    ASSERT_EQUAL(stats.extend_copies, (usize)1, "%zu");
+    ASSERT_EQUAL(stats.node_count, (usize)2, "%zu");
+    ASSERT_EQUAL(stats.free_node_count, (usize)0, "%zu");
+    ASSERT_GREATER_OR_EQUAL(stats.reserved, (usize)KiB(64 + 128), "%zu");
+    ASSERT_EQUAL(stats.committed, counted->committed, "%zu");
+    ASSERT_GREATER_OR_EQUAL(stats.commit_calls, (usize)2, "%zu");
+    ASSERT_EQUAL(stats.peak_pos, counted->pos, "%zu");
+
+    arena_clear(counted);
+    stats = arena_stats(counted);
+    ASSERT_EQUAL(stats.node_count, (usize)1, "%zu");
+    ASSERT_EQUAL(stats.free_node_count, (usize)1, "%zu");
+
+    FILE *dump = tmpfile();
+    arena_stats_dump(dump);
+    ASSERT_GREATER_THAN(ftell(dump), 0l, "%ld");
+    fclose(dump);
+    arena_delete(counted);
+}
+
+void arena_init_should_leave_the_arena_untracked(void) {
+    // Arrange
+    byte mem[KiB(4)];
+    Arena *local = arena_init(mem, sizeof(mem));
+    char address[64];
+    snprintf(address, sizeof(address), "arena %p:", (void*)local);
+    // Act
+    FILE *dump = tmpfile();
+    arena_stats_dump(dump);
+    static char text[KiB(64)];
+    rewind(dump);
+    text[fread(text, 1, sizeof(text) - 1, dump)] = '\0';
+    fclose(dump);
+    // Assert
+    ASSERT_NULL(strstr(text, address));
+}
+
+void pool_should_reuse_freed_slots(void) {
+    // Arrange
+    Pool pool = pool_new(a, 24, .align = CFLAT_CACHE_LINE_SIZE, .chunk_slots = 4);
+    void *slots[8];
+    // Act
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(slots); ++i) slots[i] = pool_alloc(&pool);
+    const usize pos = a->pos;
+    pool_free(&pool, slots[5]);
+    pool_free(&pool, slots[2]);
+    void *first  = pool_alloc(&pool);
+    void *second = pool_alloc(&pool);
+    // Assert
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(slots); ++i) {
+        ASSERT_EQUAL((uptr)slots[i] % CFLAT_CACHE_LINE_SIZE, (uptr)0, "%zu");
+    }
+    ASSERT_EQUAL(first, slots[2], "%p");
+    ASSERT_EQUAL(second, slots[5], "%p");
+    ASSERT_EQUAL(a->pos, pos, "%zu");
+
+    pool_clear(&pool);
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(slots); ++i) pool_alloc(&pool);
+    ASSERT_EQUAL(a->pos, pos, "%zu");
+}
+
+void slab_should_round_to_size_class_and_reuse(void) {
+    // Arrange
+    Arena *backing = arena_new(.reserve = MiB(1));
+    SlabAllocator *slab = slab_new(backing);
+    // Act
+    void *small = slab_alloc(slab, 20);
+    slab_free(slab, small, 20);
+    void *again = slab_alloc(slab, 30);
+    void *large = slab_alloc(slab, KiB(16));
+    // Assert
+    ASSERT_EQUAL(slab_class_size(slab_class_of(1)), (usize)16, "%zu");
+    ASSERT_EQUAL(slab_class_size(slab_class_of(65)), (usize)96, "%zu");
+    ASSERT_EQUAL(slab_class_size(slab_class_of(97)), (usize)128, "%zu");
+    ASSERT_EQUAL(slab_class_size(slab_class_of(KiB(4))), (usize)KiB(4), "%zu");
+    ASSERT_EQUAL(again, small, "%p");
+    ASSERT_EQUAL((uptr)again % 16, (uptr)0, "%zu");
+    ASSERT_NOT_NULL(large);
+    slab_free(slab, large, KiB(16));
+    slab_free(slab, again, 30);
+    arena_delete(backing);
+}
+
+void slab_should_return_null_once_a_fixed_arena_is_full(void) {
+    // Arrange
+    const usize reserve = KiB(256);
+    Arena *backing = arena_new(.reserve = reserve, .commit = reserve, .fixed_size = true);
+    SlabAllocator *slab = slab_new(backing);
+    ASSERT_NOT_NULL(slab);
+    // Act
+    usize allocated = 0, failed = 0;
+    for (usize i = 0; i < 128; ++i) {
+        u8 *slot = slab_alloc(slab, KiB(4));
+        if (slot == NULL) {
+            failed += 1;
+            continue;
+        }
+        // Assert
+        ASSERT_EQUAL(failed, (usize)0, "%zu");
+        ASSERT_TRUE(slot >= (u8*)backing && slot + KiB(4) <= (u8*)backing + reserve);
+        slot[0] = slot[KiB(4) - 1] = 0xAB;
+        allocated += 1;
+    }
+    ASSERT_TRUE(allocated > 0 && failed > 0);
+    while (arena_push(backing, 64)) {}
+    ASSERT_NULL(slab_new(backing));
+    arena_delete(backing);
+}
+
+void slice_should_grow_with_any_allocator(void) {
+    // Arrange
+    Pool pool = pool_new(a, 256);
+    Allocator allocators[] = { arena_allocator(a), libc_allocator(), pool_allocator(&pool) };
+    // Act
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(allocators); ++i) {
+        i32Slice xs = slice_new(i32Slice, allocators[i], 0);
+        for (i32 j = 0; j < 64; ++j) slice_append(allocators[i], &xs, j);
+        // Assert
+        ASSERT_EQUAL(xs.length, (usize)64, "%zu");
+        for (i32 j = 0; j < 64; ++j) ASSERT_EQUAL(xs.data[j], j, "%d");
+        slice_delete(allocators[i], &xs);
+        ASSERT_NULL(xs.data);
+    }
+    pool_delete(&pool);
+}
+
+void slice_extend_should_grow_once_and_copy(void) {
+    // Arrange
+    i32 values[100];
+    for (i32 j = 0; j < 100; ++j) values[j] = j;
+    i32Slice xs = {0};
+    // Act
+    slice_append(a, &xs, -1);
+    slice_append_many(a, &xs, values, 100);
+    const usize capacity = xs.capacity;
+    slice_extend(a, &xs, xs); // Doubles itself, reading from the memory it moves out of
+    slice_reserve_exact(a, &xs, 1000);
+    // Assert
+    ASSERT_EQUAL(capacity, (usize)101, "%zu");
+    ASSERT_EQUAL(xs.length, (usize)202, "%zu");
+    ASSERT_EQUAL(xs.capacity, (usize)1000, "%zu");
+    for (usize j = 0; j < 202; ++j) ASSERT_EQUAL(xs.data[j], (i32)(j % 101) - 1, "%d");
+    slice_reserve_exact(a, &xs, 10);
+    ASSERT_EQUAL(xs.capacity, (usize)1000, "%zu");
+    slice_delete(a, &xs);
+}
+
+typedef struct {
+    CFLAT_SEGMENTED_SLICE_FIELDS(i32);
+} i32SegmentedSlice;
+
+void segmented_slice_should_keep_element_addresses(void) {
+    // Arrange
+    i32SegmentedSlice xs = {0};
+    const usize count = 10000;
+    i32 *first = NULL, *hundredth = NULL;
+    const usize extend_copies = arena_stats(a).extend_copies;
+    // Act
+    for (usize i = 0; i < count; ++i) {
+        segmented_slice_append(a, &xs, (i32)i);
+        arena_push(a, 8); // Something else is always on top of the arena
+        if (i == 0)   first = segmented_slice_at(xs, 0);
+        if (i == 100) hundredth = segmented_slice_at(xs, 100);
+    }
+    // Assert
+    ASSERT_EQUAL(xs.length, count, "%zu");
+    ASSERT_TRUE(first == segmented_slice_at(xs, 0));
+    ASSERT_TRUE(hundredth == segmented_slice_at(xs, 100));
+    ASSERT_EQUAL(arena_stats(a).extend_copies, extend_copies, "%zu");
+    ASSERT_EQUAL(segmented_slice_segment_of(CFLAT_SEGMENTED_SLICE_FIRST - 1), (usize)0, "%zu");
+    ASSERT_EQUAL(segmented_slice_segment_of(CFLAT_SEGMENTED_SLICE_FIRST), (usize)1, "%zu");
+    for (usize i = 0; i < count; ++i) ASSERT_EQUAL(*segmented_slice_at(xs, i), (i32)i, "%d");
+    usize seen = 0;
+    segmented_slice_for_each_segment(xs, run, run_length) {
+        for (usize i = 0; i < run_length; ++i) ASSERT_EQUAL(run[i], (i32)(seen + i), "%d");
+        seen += run_length;
+    }
+    ASSERT_EQUAL(seen, count, "%zu");
+    segmented_slice_delete(a, &xs);
+    ASSERT_EQUAL(xs.capacity, (usize)0, "%zu");
+}
+
+CFLAT_SOA_SLICE(Particles, (f32, x), (f64, mass), (u8, flags), (u32, id));
+
+void soa_slice_should_keep_columns_aligned_while_growing(void) {
+    // Arrange
+    Particles ps = {0};
+    const usize count = 1000;
+    // Act
+    for (usize i = 0; i < count; ++i) {
+        ASSERT_TRUE(soa_slice_append(Particles, a, &ps, .x = (f32)i, .mass = i * 0.5, .flags = (u8)i, .id = (u32)(count - i)));
+        if (i % 3 == 0) arena_push(a, 24); // Half of the growths can't happen in place
+    }
+    soa_slice_set(Particles, &ps, 7, .x = -1.0f, .mass = 2.0, .flags = 1, .id = 9);
+    // Assert
+    ASSERT_EQUAL(ps.length, count, "%zu");
+    ASSERT_EQUAL((uptr)ps.x     % CFLAT_SOA_COLUMN_ALIGN, (uptr)0, "%zu");
+    ASSERT_EQUAL((uptr)ps.mass  % CFLAT_SOA_COLUMN_ALIGN, (uptr)0, "%zu");
+    ASSERT_EQUAL((uptr)ps.flags % CFLAT_SOA_COLUMN_ALIGN, (uptr)0, "%zu");
+    ASSERT_EQUAL((uptr)ps.id    % CFLAT_SOA_COLUMN_ALIGN, (uptr)0, "%zu");
+    for (usize i = 0; i < count; ++i) {
+        if (i == 7) continue;
+        const ParticlesRow row = soa_slice_get(Particles, &ps, i);
+        ASSERT_EQUAL(row.x, (f32)i, "%f");
+        ASSERT_EQUAL(row.mass, i * 0.5, "%f");
+        ASSERT_EQUAL(row.flags, (u8)i, "%d");
+        ASSERT_EQUAL(*soa_slice_at(ps, id, i), (u32)(count - i), "%u");
+    }
+    ASSERT_EQUAL(soa_slice_get(Particles, &ps, 7).id, 9u, "%u");
+
+    // The x column is read 8 lanes at a time with aligned loads
+    *soa_slice_at(ps, x, 7) = 7.0f;
+    CflatVec256f sum = {0};
+    for (usize i = 0; i + 8 <= count; i += 8) sum = add_v256f(sum, load_v256f(ps.x + i));
+    f32 total = 0;
+    for (usize lane = 0; lane < 8; ++lane) total += sum.v[lane];
+    ASSERT_EQUAL(total, (f32)(count * (count - 1) / 2), "%f");
+    soa_slice_delete(Particles, a, &ps);
+    ASSERT_NULL(ps.x);
+}
+
+typedef CFLAT_SMALL_SLICE(i32, 8) i32SmallSlice;
+
+void small_slice_should_stay_inline_until_it_overflows(void) {
+    // Arrange
+    i32SmallSlice xs = {0};
+    const usize pos = a->pos;
+    // Act
+    for (i32 j = 0; j < 8; ++j) small_slice_append(a, &xs, j);
+    // Assert
+    ASSERT_TRUE(small_slice_is_inline(&xs));
+    ASSERT_EQUAL(a->pos, pos, "%zu");
+    ASSERT_EQUAL(*slice_at(xs, 7), 7, "%d");
+    i32Slice tail = slice_skip(i32Slice, xs, 6);
+    ASSERT_EQUAL(tail.length, (usize)2, "%zu");
+    ASSERT_EQUAL(tail.data[0], 6, "%d");
+
+    small_slice_emplace(a, &xs, 8);
+    ASSERT_FALSE(small_slice_is_inline(&xs));
+    ASSERT_GREATER_THAN(a->pos, pos, "%zu");
+    for (i32 j = 0; j < 9; ++j) ASSERT_EQUAL(*slice_at(xs, j), j, "%d");
+    small_slice_delete(a, &xs);
+    ASSERT_TRUE(small_slice_is_inline(&xs));
+    ASSERT_EQUAL(xs.length, (usize)0, "%zu");
+}
+
+void scratch_arena_should_grow_and_decommit_when_idle(void) {
+    // Arrange
+    TempArena tmp;
+    Arena *scratch = NULL;
+    const usize size = MiB(4);
+    // Act
+    scratch_arena_scope(tmp, 1, &a) {
+        scratch = tmp.arena;
+        u8 *mem = arena_push(scratch, size);
+        ASSERT_NOT_NULL(mem);
+        mem[0] = mem[size - 1] = 0xAB;
+        ASSERT_TRUE(arena_stats(scratch).committed >= size);
+    }
+    // Assert
+    ASSERT_TRUE(scratch != a);
+    ASSERT_TRUE(arena_stats(scratch).committed <= CFLAT_SCRATCH_ARENA_KEEP_WARM + CFLAT_SCRATCH_ARENA_HYSTERESIS);
+}
+
+#if defined(OS_UNIX)
+static void* scratch_arena_thread(void *scratch) {
+    TempArena tmp = get_scratch_arena();
+    *(Arena**)scratch = tmp.arena;
+    arena_push(tmp.arena, KiB(64));
+    drop_scratch_arena(tmp);
+    return NULL;
+}
+#endif
+
+void scratch_arenas_should_be_deleted_when_their_thread_exits(void) {
+    #if defined(OS_UNIX)
+    // Arrange
+    Arena *scratch = NULL;
+    pthread_t thread;
+    // Act
+    ASSERT_EQUAL(pthread_create(&thread, NULL, scratch_arena_thread, &scratch), 0, "%d");
+    ASSERT_EQUAL(pthread_join(thread, NULL), 0, "%d");
+    // Assert
+    ASSERT_NOT_NULL(scratch);
+    bool live = false;
+    cflat__live_arenas_acquire();
+    for (Arena *arena = cflat__live_arenas; arena; arena = arena->live_next) live |= arena == scratch;
+    cflat__live_arenas_release();
+    ASSERT_FALSE(live);
+    #endif
+}
+
+void arena_prefault_should_carry_over_to_new_nodes(void) {
+    // Arrange
+    Arena *arena = arena_new(.reserve = KiB(64), .commit = KiB(4), .prefault = true);
+    // Act
+    u8 *small = arena_push(arena, KiB(32), .clear = true);
+    u8 *large = arena_push(arena, KiB(256), .clear = true);
+    // Assert
+    ASSERT_TRUE(cflat_has_flag(arena->flags, CFLAT_ARENA_PREFAULT));
+    ASSERT_TRUE(cflat_has_flag(arena->curr->flags, CFLAT_ARENA_PREFAULT));
+    ASSERT_EQUAL(small[KiB(32) - 1], 0, "%d");
+    ASSERT_EQUAL(large[KiB(256) - 1], 0, "%d");
+    arena_delete(arena);
+}
+
+void arena_commits_should_grow_geometrically(void) {
+    // Arrange
+    Arena *big = arena_new(.reserve = (usize)GiB(1), .commit = KiB(4), .fixed_size = true);
+    usize pushes = 0;
+    // Act
+    while (arena_push(big, KiB(1), .align = 1)) pushes += 1;
+    ArenaStats stats = arena_stats(big);
+    // Assert
+    ASSERT_EQUAL(pushes, (usize)(GiB(1) / KiB(1)) - 1, "%zu");
+    ASSERT_EQUAL(stats.committed, (usize)GiB(1), "%zu");
+    ASSERT_LESS_OR_EQUAL(stats.commit_calls, (usize)20, "%zu");
+    arena_delete(big);
+}
+
+void arena_large_allocations_should_remap_and_unmap_on_pop(void) {
+    // Arrange
+    Arena *arena = arena_new(.large_threshold = MiB(1));
+    u8 *small = arena_push(arena, KiB(1));
+    TempArena temp = arena_temp_begin(arena);
+    // Act
+    u8 *big = arena_push(arena, MiB(2));
+    big[0] = 1; big[MiB(2) - 1] = 2;
+    arena_push(arena, KiB(1));
+    big = arena_extend(arena, big, MiB(2), MiB(8));
+    big[MiB(8) - 1] = 3;
+    ArenaStats stats = arena_stats(arena);
+    // Assert
+    ASSERT_NOT_NULL(small);
+    ASSERT_EQUAL(big[0], 1, "%d");
+    ASSERT_EQUAL(big[MiB(2) - 1], 2, "%d");
+    ASSERT_EQUAL(stats.large_count, (usize)1, "%zu");
+    ASSERT_EQUAL(stats.large_bytes, (usize)MiB(8), "%zu");
+    ASSERT_EQUAL(stats.extend_copies, (usize)0, "%zu");
+    ASSERT_LESS_THAN(arena->pos, (usize)KiB(4), "%zu");
+
+    arena_temp_end(temp);
+    stats = arena_stats(arena);
+    ASSERT_EQUAL(stats.large_count, (usize)0, "%zu");
+    ASSERT_NULL(arena->large);
+
+    u8 *freed = arena_push(arena, MiB(1));
+    ASSERT_TRUE(arena_release_large(arena, freed));
+    ASSERT_EQUAL(arena_stats(arena).large_count, (usize)0, "%zu");
+    arena_delete(arena);
+}
+
+void arena_memory_mapped_should_grow_and_persist(void) {
+    // Arrange
+    const char *path = "arena_memory_mapped_test.bin";
+    remove(path);
+    Arena *mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    ASSERT_NOT_NULL(mapped);
+    // Act
+    u8 *first = arena_push(mapped, KiB(1));
+    u8 *big = arena_push(mapped, KiB(256));
+    const usize first_offset = (usize)(first - (u8*)mapped);
+    const usize offset = (usize)(big - (u8*)mapped);
+    for (usize i = 0; i < KiB(256); ++i) big[i] = (u8)i;
+    first[0] = 42;
+    arena_mark_dirty(mapped, first, 1);
+    ASSERT_TRUE(arena_flush(mapped));
+    const usize pos = mapped->pos;
+    arena_delete(mapped);
+
+    mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    ASSERT_NOT_NULL(mapped);
+    big = (u8*)mapped + offset;
+    // Assert
+    ASSERT_EQUAL(mapped->pos, pos, "%zu");
+    ASSERT_EQUAL(((u8*)mapped)[first_offset], 42, "%d");
+    for (usize i = 0; i < KiB(256); ++i) ASSERT_EQUAL(big[i], (u8)i, "%d");
+    ASSERT_GREATER_OR_EQUAL(arena_stats(mapped).reserved, (usize)KiB(257), "%zu");
+    arena_delete(mapped);
+    remove(path);
+}
+
+void arena_memory_mapped_should_reject_files_it_did_not_write(void) {
+    // Arrange
+    const char *path = "arena_memory_mapped_foreign.bin";
+    FILE *foreign = fopen(path, "wb");
+    ASSERT_NOT_NULL(foreign);
+    for (usize i = 0; i < KiB(4); ++i) fputc(0xAB, foreign);
+    fclose(foreign);
+    // Act
+    Arena *mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    // Assert
+    ASSERT_NULL(mapped);
+    remove(path);
+    mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    ASSERT_NOT_NULL(mapped);
+    bool live = false;
+    cflat__live_arenas_acquire();
+    for (Arena *arena = cflat__live_arenas; arena; arena = arena->live_next) live |= arena == mapped;
+    cflat__live_arenas_release();
+    ASSERT_FALSE(live);
+    arena_delete(mapped);
+    remove(path);
+}
+
+typedef struct {
+    CFLAT_REL_SLICE_FIELDS(i32);
+} i32RelSlice;
+
+typedef struct persisted_node {
+    RelPtr(struct persisted_node) next;
+    i32RelSlice values;
+} PersistedNode;
+
+void rel_ptrs_should_survive_remapping(void) {
+    // Arrange
+    const char *path = "arena_rel_ptr_test.bin";
+    remove(path);
+    Arena *mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    PersistedNode *head = NULL;
+    for (i32 i = 0; i < 3; ++i) {
+        PersistedNode *node = arena_push_struct(PersistedNode, mapped);
+        i32Slice values = slice_new(i32Slice, mapped, 0);
+        for (i32 j = 0; j <= i; ++j) slice_append(mapped, &values, i * 10 + j);
+        node->values = rel_slice_from(i32RelSlice, mapped, values);
+        rel_set(mapped, node->next, head);
+        head = node;
+    }
+    const isize root = cflat__rel_offset(mapped, head);
+    arena_delete(mapped);
+    // Act
+    mapped = arena_memory_mapped(path, KiB(4), PERMISSION_READ | PERMISSION_WRITE);
+    i32 count = 0;
+    // Assert
+    for (PersistedNode *node = (PersistedNode*)((byte*)mapped + root); node; node = rel_get(mapped, node->next)) {
+        const i32 i = 2 - count++;
+        ASSERT_EQUAL(node->values.length, (usize)(i + 1), "%zu");
+        i32Slice values = rel_slice_get(i32Slice, mapped, node->values);
+        for (i32 j = 0; j <= i; ++j) ASSERT_EQUAL(*rel_slice_at(mapped, node->values, j), values.data[j], "%d");
+        ASSERT_EQUAL(values.data[i], i * 10 + i, "%d");
+    }
+    ASSERT_EQUAL(count, 3, "%d");
+    arena_delete(mapped);
+    remove(path);
+}
+
+typedef struct snapshot_item {
+    struct snapshot_item *next;
+    u8 payload[KiB(1)];
+} SnapshotItem;
+
+void arena_restore_should_map_nodes_back_in_place(void) {
+    // Arrange
+    const char *path = "arena_snapshot_test.bin";
+    Arena *arena = arena_new(.reserve = KiB(8), .commit = KiB(4));
+    SnapshotItem *head = NULL;
+    for (usize i = 0; i < 32; ++i) {
+        SnapshotItem *item = arena_push_struct(SnapshotItem, arena, .next = head);
+        item->payload[0] = (u8)i;
+        head = item;
+    }
+    const usize pos = arena->pos;
+    const usize node_count = arena_stats(arena).node_count;
+    ASSERT_TRUE(node_count > 1);
+    ASSERT_TRUE(arena_snapshot(arena, path));
+    arena_delete(arena);
+    // Act
+    Arena *restored = arena_restore(path);
+    // Assert
+    ASSERT_TRUE(restored == arena);
+    ASSERT_EQUAL(restored->pos, pos, "%zu");
+    ASSERT_EQUAL(arena_stats(restored).node_count, node_count, "%zu");
+    usize count = 0;
+    for (SnapshotItem *item = head; item; item = item->next) {
+        ASSERT_EQUAL(item->payload[0], (u8)(31 - count), "%d");
+        count += 1;
+    }
+    ASSERT_EQUAL(count, (usize)32, "%zu");
+    ASSERT_NOT_NULL(arena_push(restored, KiB(16)));
+    ASSERT_NULL(arena_restore(path)); // The addresses are taken
+    arena_delete(restored);
+    remove(path);
+}
+
+void arena_restore_should_clear_trimmed_image_pages(void) {
+    // Arrange
+    const char *path = "arena_snapshot_trim_test.bin";
+    Arena *arena = arena_new(.reserve = MiB(1));
+    u8 *filled = arena_push(arena, KiB(256));
+    memset(filled, 0xAB, KiB(256));
+    ASSERT_TRUE(arena_snapshot(arena, path));
+    arena_delete(arena);
+    Arena *restored = arena_restore(path);
+    ASSERT_NOT_NULL(restored);
+    // Act
+    arena_clear(restored);
+    arena_trim(restored, 1);
+    u8 *cleared = arena_push(restored, KiB(256), .clear = true);
+    // Assert
+    ASSERT_NOT_NULL(cleared);
+    usize non_zero = 0;
+    for (usize i = 0; i < KiB(256); ++i) non_zero += cleared[i] != 0;
+    ASSERT_EQUAL(non_zero, (usize)0, "%zu");
+    arena_delete(restored);
+    remove(path);
+}
+
+static void corrupt_snapshot(const char *path, usize offset, u64 value, usize size) {
+    FILE *file = fopen(path, "r+b");
+    ASSERT_NOT_NULL(file);
+    fseek(file, (long)offset, SEEK_SET);
+    fwrite(&value, size, 1, file);
+    fclose(file);
+}
+
+void arena_restore_should_reject_mismatched_snapshots(void) {
+    // Arrange
+    const char *path = "arena_snapshot_corrupt_test.bin";
+    const struct { usize offset; u64 value; usize size; } corruptions[] = {
+        { offsetof(CflatArenaSnapshotHeader, arena_size), sizeof(CflatArena) + 8, sizeof(u32) },
+        { offsetof(CflatArenaSnapshotHeader, node_size),  sizeof(CflatArenaNode) + 8, sizeof(u32) },
+        { offsetof(CflatArenaSnapshotHeader, node_count), UINT64_MAX / 2, sizeof(u64) },
+        { sizeof(CflatArenaSnapshotHeader) + offsetof(CflatArenaSnapshotNode, res), KiB(4), sizeof(u64) }, // Smaller than its image
+        { 0, 0, 0 }, // Untouched, restores
+    };
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(corruptions); ++i) {
+        Arena *arena = arena_new(.reserve = KiB(64));
+        arena_push(arena, KiB(8));
+        ASSERT_TRUE(arena_snapshot(arena, path));
+        arena_delete(arena);
+        // Act
+        if (corruptions[i].size) corrupt_snapshot(path, corruptions[i].offset, corruptions[i].value, corruptions[i].size);
+        Arena *restored = arena_restore(path);
+        // Assert
+        if (corruptions[i].size) {
+            ASSERT_NULL(restored);
+        } else {
+            ASSERT_TRUE(restored == arena);
+            arena_delete(restored);
+        }
+    }
+    remove(path);
+}
+
+#define CHANNEL_TEST_MESSAGES 256
+#define CHANNEL_TEST_PAYLOAD  KiB(4)
+
+void shared_arena_channel_should_move_payloads_across_fork(void) {
+    #if defined(OS_UNIX)
+    // Arrange
+    const char *name = "/cflat_channel_test";
+    arena_shared_unlink(name);
+    Arena *shared = arena_shared(name, KiB(64));
+    ASSERT_NOT_NULL(shared);
+    ASSERT_NULL(arena_shared(name, 0)); // Its address is taken in this process
+    Channel *channel = channel_new(shared, 8);
+    u8 *payloads = arena_push(shared, channel->capacity * CHANNEL_TEST_PAYLOAD);
+    const isize channel_offset = (byte*)channel - (byte*)shared;
+    fflush(NULL);
+    // Act
+    const pid_t pid = fork();
+    ASSERT_TRUE(pid != -1);
+    if (pid == 0) {
+        // Producer, maps the arena again by name where the parent has it
+        arena_delete(shared);
+        Arena *arena = arena_shared(name, 0);
+        if (arena != shared) _exit(2);
+        Channel *tx = (Channel*)((byte*)arena + channel_offset);
+        for (usize i = 0; i < CHANNEL_TEST_MESSAGES; ++i) {
+            usize slot;
+            if (!channel_next_slot(tx, &slot)) _exit(4);
+            u8 *payload = payloads + slot * CHANNEL_TEST_PAYLOAD;
+            const usize size = 1 + (i * 97) % CHANNEL_TEST_PAYLOAD;
+            for (usize j = 0; j < size; ++j) payload[j] = (u8)(i + j);
+            if (!channel_send(tx, channel_message(arena, payload, size))) _exit(3);
+        }
+        channel_close(tx);
+        arena_delete(arena);
+        _exit(0);
+    }
+    usize received = 0;
+    ChannelMessage message;
+    while (channel_recv(channel, &message)) {
+        const u8 *payload = channel_payload(shared, message);
+        ASSERT_EQUAL(message.size, 1 + (received * 97) % CHANNEL_TEST_PAYLOAD, "%zu");
+        for (usize j = 0; j < message.size; ++j) ASSERT_EQUAL(payload[j], (u8)(received + j), "%d");
+        received += 1;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    // Assert
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQUAL(WEXITSTATUS(status), 0, "%d");
+    ASSERT_EQUAL(received, (usize)CHANNEL_TEST_MESSAGES, "%zu");
+    channel_release(channel);
+    ASSERT_EQUAL(channel_count(channel), (usize)0, "%zu");
+    ASSERT_TRUE(arena_shared_unlink(name));
+    arena_delete(shared);
+    #endif
+}
+
+void channel_next_slot_should_give_up_once_closed(void) {
+    // Arrange
+    Channel *channel = channel_new(a, 2);
+    usize slot = 0;
+    ASSERT_TRUE(channel_next_slot(channel, &slot));
+    ASSERT_EQUAL(slot, (usize)0, "%zu");
+    ASSERT_TRUE(channel_try_send(channel, (ChannelMessage){0}));
+    ASSERT_TRUE(channel_try_send(channel, (ChannelMessage){0}));
+    // Act
+    channel_close(channel);
+    // Assert
+    ASSERT_FALSE(channel_next_slot(channel, &slot));
+}
+
+void frame_arena_should_keep_the_previous_frame_alive(void) {
+    // Arrange
+    FrameArena frames = frame_arena_new(.frames = 2, .reserve = MiB(1), .keep_warm = KiB(64));
+    u32 *first = arena_push(frame_arena_current(&frames), sizeof(u32));
+    *first = 0xF00D;
+    arena_push(frame_arena_current(&frames), KiB(512));
+    // Act
+    Arena *second = frame_arena_advance(&frames);
+    u32 *second_value = arena_push(second, sizeof(u32));
+    *second_value = 0xBEEF;
+    // Assert
+    ASSERT_EQUAL(*first, 0xF00Du, "%u");
+    ASSERT_TRUE(frame_arena_previous(&frames, 1) != second);
+    ASSERT_TRUE(frame_arena_previous(&frames, 0) == second);
+    ASSERT_EQUAL(frame_arena_stats(&frames).last_peak, frame_arena_stats(&frames).max_peak, "%zu");
+    ASSERT_GREATER_OR_EQUAL(frame_arena_stats(&frames).max_peak, (usize)KiB(512), "%zu");
+
+    Arena *third = frame_arena_advance(&frames);
+    // The oldest arena was cleared and gave back what it committed for the big push
+    ASSERT_EQUAL(third->pos, (usize)0, "%zu");
+    ASSERT_LESS_OR_EQUAL(third->committed, (usize)KiB(64), "%zu");
+    ASSERT_EQUAL(*second_value, 0xBEEFu, "%u");
+    const FrameArenaStats stats = frame_arena_stats(&frames);
+    ASSERT_EQUAL((usize)stats.frames, (usize)2, "%zu");
+    ASSERT_LESS_THAN(stats.last_peak, (usize)KiB(1), "%zu");
+    ASSERT_EQUAL(stats.total_peak, stats.max_peak + stats.last_peak, "%zu");
+    frame_arena_delete(&frames);
+}
+
+void file_view_should_map_the_file_as_is_and_slide_over_it(void) {
+    // Arrange
+    const char *path = "file_view_test.bin";
+    const usize size = KiB(256) + 123;
+    FILE *file = fopen(path, "wb");
+    ASSERT_NOT_NULL(file);
+    for (usize i = 0; i < size; ++i) fputc((int)(i % 251), file);
+    fclose(file);
+    // Act
+    FileView whole = file_view_open(path, .advice = FILE_ADVICE_WILLNEED);
+    FileView windowed = file_view_open(path, .window = KiB(64), .advice = FILE_ADVICE_SEQUENTIAL);
+    FileView missing = file_view_open("file_view_test_missing.bin");
+    // Assert
+    ASSERT_NULL(missing.bytes.data);
+    ASSERT_NOT_NULL(whole.bytes.data);
+    ASSERT_EQUAL(whole.bytes.length, size, "%zu");
+    ASSERT_EQUAL(file_view_sv(&whole).length, size, "%zu");
+    ASSERT_FALSE(sv_is_nullterm(file_view_sv(&whole)));
+    for (usize i = 0; i < size; ++i) ASSERT_EQUAL(whole.bytes.data[i], (byte)(i % 251), "%d");
+
+    usize seen = 0, windows = 0;
+    do {
+        ASSERT_EQUAL(windowed.offset, seen, "%zu");
+        ASSERT_LESS_OR_EQUAL(windowed.bytes.length, (usize)KiB(64), "%zu");
+        for (usize i = 0; i < windowed.bytes.length; ++i) ASSERT_EQUAL(windowed.bytes.data[i], (byte)((seen + i) % 251), "%d");
+        seen += windowed.bytes.length;
+        windows += 1;
+    } while (file_view_next(&windowed));
+    ASSERT_EQUAL(seen, size, "%zu");
+    ASSERT_EQUAL(windows, (usize)5, "%zu");
+
+    file_view_advise(&windowed, FILE_ADVICE_RANDOM);
+    ASSERT_TRUE(file_view_seek(&windowed, KiB(100) + 7));
+    ASSERT_EQUAL(windowed.bytes.data[0], (byte)((KiB(100) + 7) % 251), "%d");
+    ASSERT_FALSE(file_view_seek(&windowed, size));
+
+    file_view_close(&whole);
+    file_view_close(&windowed);
+    file = fopen(path, "wb");
+    fclose(file);
+    FileView empty = file_view_open(path);
+    ASSERT_NOT_NULL(empty.bytes.data);
+    ASSERT_EQUAL(empty.bytes.length, (usize)0, "%zu");
+    file_view_close(&empty);
+    remove(path);
+}
+
+static int compare_u32(const void *x, const void *y) { return (*(const u32*)x > *(const u32*)y) - (*(const u32*)x < *(const u32*)y); }
+static int compare_u64(const void *x, const void *y) { return (*(const u64*)x > *(const u64*)y) - (*(const u64*)x < *(const u64*)y); }
+static int compare_i32(const void *x, const void *y) { return (*(const i32*)x > *(const i32*)y) - (*(const i32*)x < *(const i32*)y); }
+static int compare_f32(const void *x, const void *y) { return (*(const f32*)x > *(const f32*)y) - (*(const f32*)x < *(const f32*)y); }
+
+void sort_should_match_qsort_on_every_path(void) {
+    // Arrange
+    const usize counts[] = { 0, 1, 7, 16, 17, 64, 65, 300, 5000 };
+    u64 state = 0x9E3779B97F4A7C15ull;
+    const usize pos = a->pos;
+    for (usize c = 0; c < CFLAT_ARRAY_SIZE(counts); ++c) {
+        const usize n = counts[c];
+        u32 *u = arena_push_array(u32, a, n), *u_ref = arena_push_array(u32, a, n);
+        u64 *w = arena_push_array(u64, a, n), *w_ref = arena_push_array(u64, a, n);
+        i32 *s = arena_push_array(i32, a, n), *s_ref = arena_push_array(i32, a, n);
+        f32 *f = arena_push_array(f32, a, n), *f_ref = arena_push_array(f32, a, n);
+        for (usize i = 0; i < n; ++i) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            // Few distinct high bits so some radix passes get skipped
+            u[i] = (u32)(state >> 32) & (c % 2 ? 0x00FFFFFFu : UINT32_MAX);
+            w[i] = state;
+            s[i] = (i32)(state >> 20);
+            f[i] = (f32)(i32)(state >> 40) / 1024.0f;
+        }
+        memcpy(u_ref, u, n * sizeof *u);
+        memcpy(w_ref, w, n * sizeof *w);
+        memcpy(s_ref, s, n * sizeof *s);
+        memcpy(f_ref, f, n * sizeof *f);
+        const usize before = a->pos;
+        // Act
+        sort_u32(a, u, n);
+        sort_u64(a, w, n);
+        sort_i32(a, s, n);
+        sort_f32(NULL, f, n);
+        // Assert
+        ASSERT_EQUAL(a->pos, before, "%zu");
+        qsort(u_ref, n, sizeof *u_ref, compare_u32);
+        qsort(w_ref, n, sizeof *w_ref, compare_u64);
+        qsort(s_ref, n, sizeof *s_ref, compare_i32);
+        qsort(f_ref, n, sizeof *f_ref, compare_f32);
+        ASSERT_TRUE(n == 0 || memcmp(u, u_ref, n * sizeof *u) == 0);
+        ASSERT_TRUE(n == 0 || memcmp(w, w_ref, n * sizeof *w) == 0);
+        ASSERT_TRUE(n == 0 || memcmp(s, s_ref, n * sizeof *s) == 0);
+        ASSERT_TRUE(n == 0 || memcmp(f, f_ref, n * sizeof *f) == 0);
+    }
+    arena_pop(a, a->pos - pos);
+
+    // Indices with equal keys keep their order
+    f32 keys[300];
+    f32Slice key_slice = { .data = keys, .length = 300, .capacity = 300 };
+    u32Slice indices = { .data = arena_push_array(u32, a, 300), .length = 300, .capacity = 300 };
+    for (u32 i = 0; i < 300; ++i) {
+        keys[i] = (f32)((i * 7) % 10) - 4.5f;
+        indices.data[i] = 299 - i;
+    }
+    slice_sort_indices_by_f32(a, indices, key_slice);
+    for (usize i = 1; i < 300; ++i) {
+        const u32 prev = indices.data[i - 1], curr = indices.data[i];
+        ASSERT_TRUE(keys[prev] < keys[curr] || (keys[prev] == keys[curr] && prev > curr));
+    }
+}
+
+void sort_without_scratch_should_trim_the_thread_scratch_arena(void) {
+    // Arrange
+    TempArena probe = get_scratch_arena();
+    Arena *scratch = probe.arena;
+    drop_scratch_arena(probe);
+    if (scratch == a) return; // The scope holding a keeps it from going idle
+    const usize n = KiB(128);
+    u64 *w = arena_push_array(u64, a, n);
+    for (usize i = 0; i < n; ++i) w[i] = (n - i) * 0x9E3779B97F4A7C15ull;
+    // Act
+    sort_u64(NULL, w, n);
+    // Assert
+    for (usize i = 1; i < n; ++i) ASSERT_TRUE(w[i - 1] <= w[i]);
+    ASSERT_EQUAL(scratch->pos, (usize)0, "%zu");
+    ASSERT_LESS_OR_EQUAL(arena_stats(scratch).committed, (usize)(CFLAT_SCRATCH_ARENA_KEEP_WARM + CFLAT_SCRATCH_ARENA_HYSTERESIS), "%zu");
+    arena_pop(a, n * sizeof *w);
+}
+
 int main(void) {
 
     typedef void testfn(void);
@@ -154,6 +1046,38 @@ int main(void) {
         arena_da_append_should_work,
         arena_delete_wont_free_stack_memory,
         subslice_should_work,
+        arena_huge_pages_should_report_page_size,
+        arena_clear_should_decommit_above_keep_warm,
+        arena_push_clear_should_zero_recycled_memory,
+        arena_growth_should_keep_node_count_logarithmic,
+        free_list_should_pick_best_fit,
+        arena_stats_should_count_padding_and_extends,
+        arena_init_should_leave_the_arena_untracked,
+        pool_should_reuse_freed_slots,
+        slab_should_round_to_size_class_and_reuse,
+        slab_should_return_null_once_a_fixed_arena_is_full,
+        slice_should_grow_with_any_allocator,
+        slice_extend_should_grow_once_and_copy,
+        segmented_slice_should_keep_element_addresses,
+        soa_slice_should_keep_columns_aligned_while_growing,
+        small_slice_should_stay_inline_until_it_overflows,
+        scratch_arena_should_grow_and_decommit_when_idle,
+        scratch_arenas_should_be_deleted_when_their_thread_exits,
+        arena_prefault_should_carry_over_to_new_nodes,
+        arena_commits_should_grow_geometrically,
+        arena_large_allocations_should_remap_and_unmap_on_pop,
+        arena_memory_mapped_should_grow_and_persist,
+        arena_memory_mapped_should_reject_files_it_did_not_write,
+        rel_ptrs_should_survive_remapping,
+        arena_restore_should_map_nodes_back_in_place,
+        arena_restore_should_clear_trimmed_image_pages,
+        arena_restore_should_reject_mismatched_snapshots,
+        shared_arena_channel_should_move_payloads_across_fork,
+        channel_next_slot_should_give_up_once_closed,
+        frame_arena_should_keep_the_previous_frame_alive,
+        file_view_should_map_the_file_as_is_and_slide_over_it,
+        sort_should_match_qsort_on_every_path,
+        sort_without_scratch_should_trim_the_thread_scratch_arena,
     };
 
     const usize test_count = CFLAT_ARRAY_SIZE(tests);
@@ -172,11 +1096,7 @@ int main(void) {
         }
     }
 
-    TempArena tmp;
-    scratch_arena_scope(tmp, 0) {
-        arena_delete(cflat__tls_scratches[0]);
-        arena_delete(cflat__tls_scratches[1]);
-    }
+    release_scratch_arenas();
 
     printf("All tests passed ✅\n");
 
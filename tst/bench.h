@@ -0,0 +1,33 @@
+#ifndef CFLAT_BENCH_H
+#define CFLAT_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Keeps the optimizer from throwing away the result of a benchmarked expression
+#define BENCH_KEEP(x) __asm__ volatile("" : : "g"(x) : "memory")
+
+static inline void bench_report(const char *name, double total_ns, size_t ops) {
+    printf("%-40s %12.2f ms %10.2f ns/op\n", name, total_ns / 1e6, total_ns / (double)ops);
+}
+
+static int bench__compare_double(const void *a, const void *b) {
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts the samples in place and returns the one below which p percent of them fall
+static inline double bench_percentile(double *samples, size_t count, double p) {
+    qsort(samples, count, sizeof(*samples), bench__compare_double);
+    size_t index = (size_t)(p / 100.0 * (double)(count - 1) + 0.5);
+    return samples[index < count ? index : count - 1];
+}
+
+#endif //CFLAT_BENCH_H
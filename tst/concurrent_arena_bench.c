@@ -0,0 +1,131 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang concurrent_arena_bench.c -O2 -pthread -o concurrent_arena_bench.script
+./concurrent_arena_bench.script
+rm ./concurrent_arena_bench.script
+exit 0
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/CflatArena.h"
+#include "../src/CflatConcurrentArena.h"
+#include "unitest.h"
+#include "bench.h"
+
+#define MAX_THREADS 64
+#define PUSHES_PER_THREAD 200000
+#define SAMPLE_EVERY 64
+
+typedef enum {
+    MODE_CONCURRENT,
+    MODE_PER_THREAD,
+    MODE_MUTEX,
+} Mode;
+
+typedef struct {
+    Mode mode;
+    usize id;
+    ConcurrentArena *shared;
+    Arena *locked;
+    pthread_mutex_t *lock;
+    pthread_barrier_t *barrier;
+    u64 **samples;
+} Worker;
+
+static void* worker(void *arg) {
+    Worker *w = arg;
+    Arena *own = NULL;
+    if (w->mode == MODE_PER_THREAD) own = arena_new(.reserve = MiB(1));
+
+    pthread_barrier_wait(w->barrier);
+
+    for (usize i = 0; i < PUSHES_PER_THREAD; ++i) {
+        const usize size = 16 + (i & 3) * 16;
+        u64 *mem = NULL;
+        switch (w->mode) {
+        case MODE_CONCURRENT:
+            mem = concurrent_arena_push(w->shared, size);
+            break;
+        case MODE_PER_THREAD:
+            mem = arena_push(own, size);
+            break;
+        case MODE_MUTEX:
+            pthread_mutex_lock(w->lock);
+            mem = arena_push(w->locked, size);
+            pthread_mutex_unlock(w->lock);
+            break;
+        }
+        // Tag every allocation so overlapping handouts show up in the validation pass
+        for (usize j = 0; j < size / sizeof(u64); ++j) mem[j] = ((u64)w->id << 32) | i;
+        if (i % SAMPLE_EVERY == 0) w->samples[i / SAMPLE_EVERY] = mem;
+        BENCH_KEEP(mem);
+    }
+
+    if (own) arena_delete(own);
+    return NULL;
+}
+
+static double run(Mode mode, usize thread_count, ConcurrentArena *shared) {
+    pthread_t threads[MAX_THREADS];
+    Worker workers[MAX_THREADS];
+    u64 **samples = malloc(thread_count * (PUSHES_PER_THREAD / SAMPLE_EVERY + 1) * sizeof(*samples));
+    pthread_barrier_t barrier;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    Arena *locked = arena_new(.reserve = MiB(1));
+
+    pthread_barrier_init(&barrier, NULL, (unsigned)thread_count + 1);
+    for (usize i = 0; i < thread_count; ++i) {
+        workers[i] = (Worker) {
+            .mode = mode, .id = i, .shared = shared, .locked = locked,
+            .lock = &lock, .barrier = &barrier,
+            .samples = samples + i * (PUSHES_PER_THREAD / SAMPLE_EVERY + 1),
+        };
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    const double begin = bench_now_ns();
+    for (usize i = 0; i < thread_count; ++i) pthread_join(threads[i], NULL);
+    const double elapsed = bench_now_ns() - begin;
+
+    if (mode == MODE_CONCURRENT) {
+        for (usize i = 0; i < thread_count; ++i) {
+            for (usize j = 0; j < PUSHES_PER_THREAD; j += SAMPLE_EVERY) {
+                ASSERT_EQUAL((usize)workers[i].samples[j / SAMPLE_EVERY][0], (usize)(((u64)i << 32) | j), "%zu");
+            }
+        }
+    }
+
+    free(samples);
+
+    pthread_barrier_destroy(&barrier);
+    arena_delete(locked);
+    return elapsed;
+}
+
+int main(void) {
+    const usize thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    for (usize t = 0; t < CFLAT_ARRAY_SIZE(thread_counts); ++t) {
+        const usize n = thread_counts[t];
+        const usize ops = n * PUSHES_PER_THREAD;
+        char name[64];
+
+        ConcurrentArena *shared = concurrent_arena_new();
+        snprintf(name, sizeof name, "concurrent arena  %2zu threads", n);
+        bench_report(name, run(MODE_CONCURRENT, n, shared), ops);
+        concurrent_arena_delete(shared);
+
+        snprintf(name, sizeof name, "per-thread arena  %2zu threads", n);
+        bench_report(name, run(MODE_PER_THREAD, n, NULL), ops);
+
+        snprintf(name, sizeof name, "mutex arena       %2zu threads", n);
+        bench_report(name, run(MODE_MUTEX, n, NULL), ops);
+    }
+
+    return 0;
+}
@@ -15,6 +15,7 @@ exit 0
 #include "../src/CflatArena.h"
 #include "../src/CflatString.h"
 #include "../src/CflatRegex.h"
+#include "../src/CflatSlab.h"
 
 typedef void testfn(void);
 
@@ -32,6 +33,19 @@ void sv_find_last_index_should_work(void) {
     ASSERT_EQUAL(sv_find_last_index(sv_from_cstr("BarFooFoo"), "BarFoo"), 0L, "%ld");
 }
 
+void sv_find_index_should_work_with_long_substrings(void) {
+    // The kmp table is 256 bytes per state, past what a 64 KiB scratch arena can hold
+    char needle[250];
+    char haystack[1024];
+    memset(needle, 'a', sizeof needle);
+    memset(haystack, 'a', sizeof haystack);
+    needle[sizeof needle - 1] = 'b';
+    haystack[sizeof haystack - 1] = 'b';
+    CflatStringView string = { .data = haystack, .length = sizeof haystack };
+    CflatStringView substring = { .data = needle, .length = sizeof needle };
+    ASSERT_EQUAL(cflat_sv_find_index(string, substring), (isize)(sizeof haystack - sizeof needle), "%zd");
+}
+
 void nfa_literal_match_test(void) {
     CflatArena *arena = cflat_arena_new(); 
     CflatNfa nfa = cflat_nfa_new(arena);  
@@ -372,10 +386,70 @@ void test_nfa_groups(void) {
     cflat_arena_delete(arena);
 }
 
+void nfa_clear_should_reuse_transitions(void) {
+    CflatArena *arena = cflat_arena_new();
+    CflatNfa nfa = cflat_nfa_new(arena);
+
+    cflat_nfa_match_opt(&nfa, cflat_sv_from_cstr("hello"), CFLAT_MATCH_ONE | CFLAT_CASE_INSENSTIVE);
+    const usize pos = arena->pos;
+
+    for (usize i = 0; i < 100; ++i) {
+        cflat_nfa_clear(&nfa);
+        cflat_nfa_match_opt(&nfa, cflat_sv_from_cstr("world"), CFLAT_MATCH_ONE | CFLAT_CASE_INSENSTIVE);
+    }
+
+    ASSERT_EQUAL(arena->pos, pos, "%zu");
+    ASSERT_EQUAL(cflat_nfa_matches(nfa, cflat_sv_from_cstr("WoRlD")).length, 5L, "%lu");
+    ASSERT_NULL(cflat_nfa_matches(nfa, cflat_sv_from_cstr("hello")).data);
+
+    cflat_arena_delete(arena);
+}
+
+void nfa_should_work_with_any_allocator(void) {
+    CflatArena *backing = cflat_arena_new();
+    CflatSlabAllocator *slab = cflat_slab_new(backing);
+    CflatAllocator allocators[] = { cflat_libc_allocator(), cflat_slab_allocator(slab) };
+
+    for (usize i = 0; i < CFLAT_ARRAY_SIZE(allocators); ++i) {
+        CflatNfa nfa = cflat_nfa_new(allocators[i]);
+        cflat_nfa_begin_group(&nfa);
+        cflat_nfa_match_opt(&nfa, cflat_sv_from_cstr("ab"), CFLAT_MATCH_ONE);
+        cflat_nfa_or_opt(&nfa, cflat_sv_from_cstr("cd"), CFLAT_MATCH_ONE);
+        cflat_nfa_end_group_opt(&nfa, CFLAT_MATCH_ONE_OR_MORE);
+
+        CflatStringView text = cflat_sv_printf(allocators[i], "%s%s", "cd", "ab");
+        ASSERT_EQUAL(cflat_nfa_matches(nfa, text).length, 4L, "%lu");
+        CflatStringView copy = cflat_sv_clone(allocators[i], text);
+        ASSERT_EQUAL(cflat_nfa_matches(nfa, copy).length, 4L, "%lu");
+
+        cflat_sv_delete(allocators[i], copy);
+        cflat_sv_delete(allocators[i], text);
+        cflat_nfa_delete(&nfa);
+    }
+
+    cflat_arena_delete(backing);
+}
+
+void dfa_should_run_from_a_restored_arena(void) {
+    const char *path = "dfa_snapshot_test.bin";
+    CflatArena *arena = cflat_arena_new();
+    CflatDfaKmp *dfa = cflat_dfa_kmp_new(arena, 4, UCHAR_MAX + 1);
+    cflat_dfa_kmp_match_sv(dfa, cflat_sv_from_cstr("Foo"));
+    ASSERT_TRUE(cflat_arena_snapshot(arena, path));
+    cflat_arena_delete(arena);
+
+    arena = cflat_arena_restore(path);
+    ASSERT_NOT_NULL(arena);
+    ASSERT_EQUAL(cflat_dfa_run_sv(dfa, cflat_sv_from_cstr("BarFooFoo")), 3L, "%ld");
+    cflat_arena_delete(arena);
+    remove(path);
+}
+
 int main() {
     
     sv_find_index_should_work();
     sv_find_last_index_should_work();
+    sv_find_index_should_work_with_long_substrings();
 
     nfa_literal_match_test();
     nfa_case_match_test();
@@ -394,7 +468,11 @@ int main() {
     nfa_match_alternation_quantified_rhs();
 
     test_nfa_groups();
+    nfa_clear_should_reuse_transitions();
+    nfa_should_work_with_any_allocator();
+    dfa_should_run_from_a_restored_arena();
 
+    cflat_release_scratch_arenas();
     printf("All Tests Passed\n");
     return 0;
 }
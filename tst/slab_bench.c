@@ -0,0 +1,149 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang slab_bench.c -O2 -pthread -o slab_bench.script
+./slab_bench.script
+rm ./slab_bench.script
+exit 0
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/CflatArena.h"
+#include "../src/CflatSlab.h"
+#include "unitest.h"
+#include "bench.h"
+
+#define TRACE_LENGTH 2000000
+#define MAX_LIVE     4096
+#define MAX_THREADS  8
+
+typedef struct {
+    u32 slot;
+    u32 size; // 0 frees the slot
+} TraceOp;
+
+typedef enum {
+    MODE_SLAB,
+    MODE_MALLOC,
+} Mode;
+
+typedef struct {
+    Mode mode;
+    SlabAllocator *slab;
+    const TraceOp *trace;
+    pthread_barrier_t *barrier;
+} Worker;
+
+static u64 rng_next(u64 *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Mostly small strings and nodes with a tail of bigger buffers, frees hit random live objects
+static TraceOp* make_trace(u64 seed) {
+    TraceOp *trace = malloc(TRACE_LENGTH * sizeof(*trace));
+    u32 live[MAX_LIVE], free_slots[MAX_LIVE];
+    u32 live_count = 0, free_count = MAX_LIVE;
+    for (u32 i = 0; i < MAX_LIVE; ++i) free_slots[i] = MAX_LIVE - 1 - i;
+
+    for (usize i = 0; i < TRACE_LENGTH; ++i) {
+        const u64 r = rng_next(&seed);
+        const bool alloc = free_count > 0 && (live_count == 0 || (r & 1));
+        if (alloc) {
+            const u64 bucket = (r >> 8) % 100;
+            u32 size;
+            if (bucket < 70)      size = 8   + (u32)((r >> 16) % 56);
+            else if (bucket < 95) size = 64  + (u32)((r >> 16) % 448);
+            else                  size = 512 + (u32)((r >> 16) % 3584);
+            const u32 slot = free_slots[--free_count];
+            live[live_count++] = slot;
+            trace[i] = (TraceOp){ .slot = slot, .size = size };
+        } else {
+            const u32 index = (u32)((r >> 8) % live_count);
+            const u32 slot = live[index];
+            live[index] = live[--live_count];
+            free_slots[free_count++] = slot;
+            trace[i] = (TraceOp){ .slot = slot, .size = 0 };
+        }
+    }
+    return trace;
+}
+
+static void* worker(void *arg) {
+    Worker *w = arg;
+    void *ptrs[MAX_LIVE] = {0};
+    u32 sizes[MAX_LIVE] = {0};
+
+    pthread_barrier_wait(w->barrier);
+
+    for (usize i = 0; i < TRACE_LENGTH; ++i) {
+        const TraceOp op = w->trace[i];
+        if (op.size) {
+            u8 *mem = w->mode == MODE_SLAB ? slab_alloc(w->slab, op.size) : malloc(op.size);
+            mem[0] = mem[op.size - 1] = (u8)op.slot;
+            ptrs[op.slot] = mem;
+            sizes[op.slot] = op.size;
+        } else {
+            u8 *mem = ptrs[op.slot];
+            ASSERT_EQUAL(mem[sizes[op.slot] - 1], (u8)op.slot, "%u");
+            if (w->mode == MODE_SLAB) slab_free(w->slab, mem, sizes[op.slot]);
+            else free(mem);
+            sizes[op.slot] = 0;
+        }
+    }
+
+    for (usize i = 0; i < MAX_LIVE; ++i) {
+        if (sizes[i] == 0) continue;
+        if (w->mode == MODE_SLAB) slab_free(w->slab, ptrs[i], sizes[i]);
+        else free(ptrs[i]);
+    }
+    return NULL;
+}
+
+static double run(Mode mode, usize thread_count, TraceOp **traces) {
+    pthread_t threads[MAX_THREADS];
+    Worker workers[MAX_THREADS];
+    pthread_barrier_t barrier;
+    Arena *arena = arena_new(.reserve = MiB(64));
+    SlabAllocator *slab = slab_new(arena);
+
+    pthread_barrier_init(&barrier, NULL, (unsigned)thread_count + 1);
+    for (usize i = 0; i < thread_count; ++i) {
+        workers[i] = (Worker){ .mode = mode, .slab = slab, .trace = traces[i], .barrier = &barrier };
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    pthread_barrier_wait(&barrier);
+    const double begin = bench_now_ns();
+    for (usize i = 0; i < thread_count; ++i) pthread_join(threads[i], NULL);
+    const double elapsed = bench_now_ns() - begin;
+
+    pthread_barrier_destroy(&barrier);
+    arena_delete(arena);
+    return elapsed;
+}
+
+int main(void) {
+    TraceOp *traces[MAX_THREADS];
+    for (usize i = 0; i < MAX_THREADS; ++i) traces[i] = make_trace(0x9E3779B97F4A7C15ull + i);
+
+    const usize thread_counts[] = { 1, 2, 4, 8 };
+    for (usize t = 0; t < CFLAT_ARRAY_SIZE(thread_counts); ++t) {
+        const usize n = thread_counts[t];
+        char name[64];
+
+        snprintf(name, sizeof name, "slab allocator %zu threads", n);
+        bench_report(name, run(MODE_SLAB, n, traces), n * TRACE_LENGTH);
+
+        snprintf(name, sizeof name, "malloc/free    %zu threads", n);
+        bench_report(name, run(MODE_MALLOC, n, traces), n * TRACE_LENGTH);
+    }
+
+    for (usize i = 0; i < MAX_THREADS; ++i) free(traces[i]);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang slice_append_bench.c -O2 -o slice_append_bench.script
+./slice_append_bench.script
+rm ./slice_append_bench.script
+exit 0
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/Cflat.h"
+#include "bench.h"
+
+#define ELEMENTS (100 * 1000 * 1000)
+#define CHUNK    4096
+
+typedef struct {
+    CFLAT_SLICE_FIELDS(u32);
+} u32Slice;
+
+typedef enum {
+    MODE_APPEND,
+    MODE_APPEND_MANY,
+    MODE_RESERVE_EXACT,
+} Mode;
+
+static u32 chunk[CHUNK];
+
+// Builds the same slice of ELEMENTS u32, a chunk at a time for the bulk modes
+static double build(Allocator allocator, Mode mode) {
+    u32Slice xs = {0};
+    const double begin = bench_now_ns();
+    switch (mode) {
+    case MODE_APPEND:
+        for (u32 i = 0; i < ELEMENTS; ++i) slice_append(allocator, &xs, chunk[i % CHUNK]);
+        break;
+    case MODE_RESERVE_EXACT:
+        slice_reserve_exact(allocator, &xs, ELEMENTS);
+        // fallthrough
+    case MODE_APPEND_MANY:
+        for (usize i = 0; i < ELEMENTS; i += CHUNK) slice_append_many(allocator, &xs, chunk, cflat_min((usize)CHUNK, ELEMENTS - i));
+        break;
+    }
+    BENCH_KEEP(xs.data);
+    const double elapsed = bench_now_ns() - begin;
+
+    if (xs.length != ELEMENTS || xs.data[ELEMENTS - 1] != chunk[(ELEMENTS - 1) % CHUNK]) {
+        fprintf(stderr, "wrong slice\n");
+        exit(1);
+    }
+    slice_delete(allocator, &xs);
+    return elapsed;
+}
+
+int main(void) {
+    for (u32 i = 0; i < CHUNK; ++i) chunk[i] = i * 2654435761u;
+
+    Arena *arena = arena_new(.reserve = (usize)GiB(1));
+    const struct { const char *name; Allocator allocator; } allocators[] = {
+        { "arena", arena_allocator(arena) },
+        { "libc",  libc_allocator() },
+    };
+    const struct { const char *name; Mode mode; } modes[] = {
+        { "append",                 MODE_APPEND },
+        { "append_many",            MODE_APPEND_MANY },
+        { "reserve_exact + many",   MODE_RESERVE_EXACT },
+    };
+
+    // The arena keeps its pages committed across clears, touch them once so no arena run pays for the page faults
+    build(arena_allocator(arena), MODE_RESERVE_EXACT);
+    arena_clear(arena);
+
+    for (usize a = 0; a < CFLAT_ARRAY_SIZE(allocators); ++a) {
+        for (usize m = 0; m < CFLAT_ARRAY_SIZE(modes); ++m) {
+            char name[64];
+            snprintf(name, sizeof name, "%-5s %s", allocators[a].name, modes[m].name);
+            bench_report(name, build(allocators[a].allocator, modes[m].mode), ELEMENTS);
+            arena_clear(arena);
+        }
+    }
+
+    arena_delete(arena);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#if 0 && BASH
+#!usr/bin/bash
+clang sort_bench.c -O2 -march=native -o sort_bench.script
+./sort_bench.script
+rm ./sort_bench.script
+exit 0
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CFLAT_IMPLEMENTATION
+#include "../src/Cflat.h"
+#include "../src/CflatSort.h"
+#include "bench.h"
+
+#define MIN_COUNT 1000
+#define MAX_COUNT (100 * 1000 * 1000)
+#define TOTAL     (10 * 1000 * 1000) // Small sizes are sorted again until this many keys went through
+
+typedef enum {
+    KEYS_U32,
+    KEYS_U64,
+    KEYS_F32,
+    KEYS_INDICES_BY_U32,
+} Keys;
+
+typedef enum {
+    SORT_CFLAT,
+    SORT_QSORT,
+} Sort;
+
+static int compare_u32(const void *x, const void *y) { return (*(const u32*)x > *(const u32*)y) - (*(const u32*)x < *(const u32*)y); }
+static int compare_u64(const void *x, const void *y) { return (*(const u64*)x > *(const u64*)y) - (*(const u64*)x < *(const u64*)y); }
+static int compare_f32(const void *x, const void *y) { return (*(const f32*)x > *(const f32*)y) - (*(const f32*)x < *(const f32*)y); }
+
+static const u32 *qsort_keys;
+static int compare_index(const void *x, const void *y) {
+    const u32 a = qsort_keys[*(const u32*)x], b = qsort_keys[*(const u32*)y];
+    return (a > b) - (a < b);
+}
+
+static u64 state = 0x9E3779B97F4A7C15ull;
+static inline u64 next_random(void) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return state;
+}
+
+static void fill(Keys keys, void *data, u32 *indices, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        const u64 r = next_random();
+        switch (keys) {
+        case KEYS_U32:            ((u32*)data)[i] = (u32)(r >> 32);                          break;
+        case KEYS_U64:            ((u64*)data)[i] = r;                                       break;
+        case KEYS_F32:            ((f32*)data)[i] = (f32)(i32)(r >> 32) / 65536.0f;          break;
+        case KEYS_INDICES_BY_U32: ((u32*)data)[i] = (u32)(r >> 32); indices[i] = (u32)i;     break;
+        }
+    }
+}
+
+static bool is_sorted(Keys keys, const void *data, const u32 *indices, usize count) {
+    for (usize i = 1; i < count; ++i) {
+        switch (keys) {
+        case KEYS_U32:            if (((u32*)data)[i - 1] > ((u32*)data)[i]) return false;                               break;
+        case KEYS_U64:            if (((u64*)data)[i - 1] > ((u64*)data)[i]) return false;                               break;
+        case KEYS_F32:            if (((f32*)data)[i - 1] > ((f32*)data)[i]) return false;                               break;
+        case KEYS_INDICES_BY_U32: if (((u32*)data)[indices[i - 1]] > ((u32*)data)[indices[i]]) return false;             break;
+        }
+    }
+    return true;
+}
+
+// Sorts fresh random keys until TOTAL of them went through, only the sorting is timed
+static double run(Arena *scratch, Keys keys, Sort sort, void *data, u32 *indices, usize count) {
+    double elapsed = 0;
+    for (usize sorted = 0; sorted < TOTAL || sorted == 0; sorted += count) {
+        fill(keys, data, indices, count);
+        const double begin = bench_now_ns();
+        switch (sort) {
+        case SORT_CFLAT:
+            switch (keys) {
+            case KEYS_U32:            sort_u32(scratch, data, count);                  break;
+            case KEYS_U64:            sort_u64(scratch, data, count);                  break;
+            case KEYS_F32:            sort_f32(scratch, data, count);                  break;
+            case KEYS_INDICES_BY_U32: sort_indices_by_u32(scratch, indices, count, data); break;
+            }
+            break;
+        case SORT_QSORT:
+            switch (keys) {
+            case KEYS_U32:            qsort(data, count, sizeof(u32), compare_u32);    break;
+            case KEYS_U64:            qsort(data, count, sizeof(u64), compare_u64);    break;
+            case KEYS_F32:            qsort(data, count, sizeof(f32), compare_f32);    break;
+            case KEYS_INDICES_BY_U32: qsort_keys = data; qsort(indices, count, sizeof(u32), compare_index); break;
+            }
+            break;
+        }
+        BENCH_KEEP(data);
+        elapsed += bench_now_ns() - begin;
+
+        if (!is_sorted(keys, data, indices, count)) {
+            fprintf(stderr, "not sorted\n");
+            exit(1);
+        }
+    }
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    // The biggest size sorts 1.6 GiB of u64 with its scratch, pass a smaller maximum on small machines
+    const usize max_count = argc > 1 ? (usize)strtoull(argv[1], NULL, 10) : MAX_COUNT;
+
+    Arena *scratch = arena_new(.reserve = (usize)4 * GiB(1));
+    u64 *data    = malloc(max_count * sizeof(u64));
+    u32 *indices = malloc(max_count * sizeof(u32));
+    if (data == NULL || indices == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    const struct { const char *name; Keys keys; } key_kinds[] = {
+        { "u32",            KEYS_U32 },
+        { "u64",            KEYS_U64 },
+        { "f32",            KEYS_F32 },
+        { "indices by u32", KEYS_INDICES_BY_U32 },
+    };
+    const struct { const char *name; Sort sort; } sorts[] = {
+        { "cflat", SORT_CFLAT },
+        { "qsort", SORT_QSORT },
+    };
+
+    for (usize count = MIN_COUNT; count <= max_count; count *= 10) {
+        for (usize k = 0; k < CFLAT_ARRAY_SIZE(key_kinds); ++k) {
+            for (usize s = 0; s < CFLAT_ARRAY_SIZE(sorts); ++s) {
+                char name[64];
+                snprintf(name, sizeof name, "%-5s %-14s %zu", sorts[s].name, key_kinds[k].name, count);
+                const usize sorted = cflat_max(count, (usize)TOTAL / count * count);
+                bench_report(name, run(scratch, key_kinds[k].keys, sorts[s].sort, data, indices, count), sorted);
+            }
+        }
+        printf("\n");
+    }
+
+    free(indices);
+    free(data);
+    arena_delete(scratch);
+    return 0;
+}